@@ -1,4 +1,7 @@
 #include <catch.hpp>
+#include <algorithm>
+#include <atomic>
+#include <thread>
 #include "ecs/ecs.h"
 using namespace EECS;
 
@@ -96,9 +99,7 @@ TEST_CASE("Time to next task update with single task returns approx. task freq -
 
     auto timeToNextUpdate = taskManager.update(std::chrono::milliseconds(3));
 
-    // time that passed since last task update should be substracted, but std::chrono::milliseconds is integer so
-    // this negligable(in this case) amount of time will be discarded anyway.
-    REQUIRE(timeToNextUpdate.count() == 10 - 3);
+    REQUIRE(timeToNextUpdate == std::chrono::milliseconds(10 - 3));
 }
 
 TEST_CASE("Time to next task update with single task returns approx. tasks(min(task.freq - task.accumulatedTime))") {
@@ -112,9 +113,48 @@ TEST_CASE("Time to next task update with single task returns approx. tasks(min(t
 
     auto timeToNextUpdate = taskManager.update(std::chrono::milliseconds(100));
 
-    // time that passed since last task update should be substracted, but std::chrono::milliseconds is integer so
-    // this negligable(in this case) amount of time will be discarded anyway.
-    REQUIRE(timeToNextUpdate.count() == 1);
+    REQUIRE(timeToNextUpdate == std::chrono::milliseconds(1));
+}
+
+TEST_CASE("Fractional frequencies don't drift", "[TaskScheduler]") {
+    ECS engine;
+    TaskScheduler taskManager(engine);
+
+    auto sampleTask = taskManager.addTask<TestTask>();
+    sampleTask->setRate(144.0);
+    REQUIRE(sampleTask->frequency == std::chrono::nanoseconds(6944444));
+
+    // 1000 frames of a bit over 1ms, so task is always updated a bit late
+    for (auto i = 0; i < 1000; i++) {
+        taskManager.update(std::chrono::microseconds(1001));
+    }
+
+    // 1.001s at 144Hz
+    REQUIRE(sampleTask->updateCounter == 144);
+    REQUIRE(sampleTask->timing.updates == 144);
+    REQUIRE(sampleTask->timing.maxError < std::chrono::microseconds(1001));
+    REQUIRE(sampleTask->timing.meanError() <= sampleTask->timing.maxError);
+    REQUIRE(sampleTask->interpolation() >= 0.0);
+    REQUIRE(sampleTask->interpolation() < 1.0);
+}
+
+TEST_CASE("Task which fell behind catches up to its limit", "[TaskScheduler]") {
+    ECS engine;
+    TaskScheduler taskManager(engine);
+
+    auto sampleTask = taskManager.addTask<TestTask>();
+    sampleTask->frequency = std::chrono::milliseconds(10);
+    sampleTask->maxCatchUp = 3;
+
+    taskManager.update(std::chrono::milliseconds(105));
+    REQUIRE(sampleTask->updateCounter == 3);
+    REQUIRE(sampleTask->timing.skippedUpdates == 7);
+
+    // fraction of interval is kept
+    REQUIRE(sampleTask->interpolation() == Approx(0.5));
+    taskManager.update(std::chrono::milliseconds(5));
+    REQUIRE(sampleTask->updateCounter == 4);
+    REQUIRE(sampleTask->timing.lastError == std::chrono::milliseconds(0));
 }
 
 TEST_CASE("Task retrieval and delete test") {
@@ -130,3 +170,143 @@ TEST_CASE("Task retrieval and delete test") {
     taskManager.deleteTask<TestTask>();
     REQUIRE(!taskManager.getTask<TestTask>());
 }
+
+TEST_CASE("Time to next task update without tasks is finite", "[TaskScheduler]") {
+    ECS engine;
+    TaskScheduler taskManager(engine);
+    REQUIRE(taskManager.update(std::chrono::milliseconds(1)) == TaskScheduler::idleInterval);
+
+    auto testTask = taskManager.addTask<TestTask>();
+    testTask->frequency = std::chrono::milliseconds(100);
+    REQUIRE(taskManager.update(std::chrono::milliseconds(1)) == std::chrono::milliseconds(99));
+
+    // all tasks deleted
+    taskManager.deleteTask<TestTask>();
+    REQUIRE(taskManager.update(std::chrono::milliseconds(1)) == TaskScheduler::idleInterval);
+}
+
+struct ScheduledPosition;
+struct ScheduledMovement;
+
+// state shared by tasks below, so tests can check how they were run
+struct ScheduleProbe {
+    std::thread::id mainThread = std::this_thread::get_id();
+    std::atomic<int> waiting{0};
+    std::atomic<bool> overlapped{false};
+    std::atomic<bool> drawnOnMainThread{false};
+};
+
+class MoverTask : public Task<MoverTask, Reads<ScheduledMovement>, Writes<ScheduledPosition>> {
+public:
+    MoverTask(ECS& engine, ScheduleProbe&) : Task(engine) {}
+
+    void update() override {}
+};
+
+class DrawerTask : public Task<DrawerTask, MainThread, Reads<ScheduledPosition>> {
+public:
+    DrawerTask(ECS& engine, ScheduleProbe& probe) : Task(engine), probe(probe) {}
+
+    void update() override { probe.drawnOnMainThread = std::this_thread::get_id() == probe.mainThread; }
+
+    ScheduleProbe& probe;
+};
+
+namespace {
+// waits until another task is running at the same time, or gives up after a second
+void waitForOverlap(ScheduleProbe& probe) {
+    probe.waiting++;
+    auto waitStart = std::chrono::steady_clock::now();
+    while (probe.waiting < 2 && std::chrono::steady_clock::now() - waitStart < std::chrono::seconds(1)) {
+        std::this_thread::yield();
+    }
+    probe.overlapped = probe.waiting >= 2;
+}
+}
+
+class FirstOverlappingTask : public Task<FirstOverlappingTask, Reads<>> {
+public:
+    FirstOverlappingTask(ECS& engine, ScheduleProbe& probe) : Task(engine), probe(probe) {}
+
+    void update() override { waitForOverlap(probe); }
+
+    ScheduleProbe& probe;
+};
+
+class SecondOverlappingTask : public Task<SecondOverlappingTask, Reads<>> {
+public:
+    SecondOverlappingTask(ECS& engine, ScheduleProbe& probe) : Task(engine), probe(probe) {}
+
+    void update() override { waitForOverlap(probe); }
+
+    ScheduleProbe& probe;
+};
+
+namespace {
+// returns index of stage which contains task, or -1
+template <typename TaskClass>
+int stageOf(const TaskScheduler& scheduler) {
+    const auto& schedule = scheduler.getSchedule();
+    for (auto i = 0u; i < schedule.size(); i++) {
+        if (std::find(schedule[i].begin(), schedule[i].end(), TaskID::get<TaskClass>()) != schedule[i].end()) {
+            return (int)i;
+        }
+    }
+    return -1;
+}
+}
+
+TEST_CASE("Conflicting tasks are ordered by TaskID, others share stages", "[TaskScheduler]") {
+    ECS engine;
+    engine.threadPool.resize(2);
+    TaskScheduler taskManager(engine);
+    ScheduleProbe probe;
+
+    taskManager.addTask<MoverTask>(probe)->frequency = std::chrono::milliseconds(1);
+    taskManager.addTask<DrawerTask>(probe)->frequency = std::chrono::milliseconds(1);
+    taskManager.addTask<FirstOverlappingTask>(probe)->frequency = std::chrono::milliseconds(1);
+    taskManager.update(std::chrono::milliseconds(1));
+
+    // Drawer reads what Mover writes, so they're in separate stages, in TaskID order
+    REQUIRE(taskManager.getSchedule().size() == 2);
+    auto moverFirst = TaskID::get<MoverTask>() < TaskID::get<DrawerTask>();
+    REQUIRE(stageOf<MoverTask>(taskManager) == (moverFirst ? 0 : 1));
+    REQUIRE(stageOf<DrawerTask>(taskManager) == (moverFirst ? 1 : 0));
+
+    // task which doesn't access anything doesn't wait for anything
+    REQUIRE(stageOf<FirstOverlappingTask>(taskManager) == 0);
+
+    REQUIRE(probe.drawnOnMainThread);
+    REQUIRE(taskManager.describeSchedule().find(" -> ") != std::string::npos);
+}
+
+TEST_CASE("Tasks without declared access run alone", "[TaskScheduler]") {
+    ECS engine;
+    engine.threadPool.resize(2);
+    TaskScheduler taskManager(engine);
+    ScheduleProbe probe;
+
+    taskManager.addTask<TestTask>()->frequency = std::chrono::milliseconds(1);
+    taskManager.addTask<FirstOverlappingTask>(probe)->frequency = std::chrono::milliseconds(1);
+    taskManager.addTask<SecondOverlappingTask>(probe)->frequency = std::chrono::milliseconds(1);
+    taskManager.update(std::chrono::milliseconds(1));
+
+    auto& schedule = taskManager.getSchedule();
+    auto testTaskStage = stageOf<TestTask>(taskManager);
+    REQUIRE(testTaskStage >= 0);
+    REQUIRE(schedule[testTaskStage].size() == 1);
+}
+
+TEST_CASE("Non-conflicting tasks run concurrently", "[TaskScheduler]") {
+    ECS engine;
+    engine.threadPool.resize(2);
+    TaskScheduler taskManager(engine);
+    ScheduleProbe probe;
+
+    taskManager.addTask<FirstOverlappingTask>(probe);
+    taskManager.addTask<SecondOverlappingTask>(probe);
+    taskManager.update(std::chrono::milliseconds(16));
+
+    REQUIRE(taskManager.getSchedule().size() == 1);
+    REQUIRE(probe.overlapped);
+}
@@ -0,0 +1,173 @@
+#include <catch.hpp>
+#include <string>
+#include "ecs/ecs.h"
+using namespace EECS;
+
+struct ChunkedPosition : public Component<ChunkedPosition> {
+    static constexpr ComponentStorage storage = ComponentStorage::Archetype;
+
+    explicit ChunkedPosition(int x = 0) : x(x) {}
+
+    int x = 0;
+};
+
+struct ChunkedName : public Component<ChunkedName> {
+    static constexpr ComponentStorage storage = ComponentStorage::Archetype;
+
+    explicit ChunkedName(std::string name = "") : name(std::move(name)) {}
+
+    std::string name;
+};
+
+struct SortedTag : public Component<SortedTag> {
+    explicit SortedTag(int tag = 0) : tag(tag) {}
+
+    int tag = 0;
+};
+
+TEST_CASE("Archetype-stored components can be added, retrieved and deleted") {
+    ComponentManager comps;
+
+    REQUIRE(comps.addComponent<ChunkedPosition>(1, 11));
+    REQUIRE(comps.getComponent<ChunkedPosition>(1)->x == 11);
+    REQUIRE(!comps.getComponent<ChunkedPosition>(2));
+
+    // adding second type moves entity to other archetype, components keep their values
+    REQUIRE(comps.addComponent<ChunkedName>(1, "first"));
+    REQUIRE(comps.getComponent<ChunkedPosition>(1)->x == 11);
+    REQUIRE(comps.getComponent<ChunkedName>(1)->name == "first");
+    REQUIRE(comps.getComponent<ChunkedName>(1)->entityID == 1);
+
+    // adding again replaces component
+    comps.addComponent<ChunkedPosition>(1, 12);
+    REQUIRE(comps.getComponent<ChunkedPosition>(1)->x == 12);
+
+    REQUIRE(comps.deleteComponent<ChunkedPosition>(1));
+    REQUIRE(!comps.deleteComponent<ChunkedPosition>(1));
+    REQUIRE(!comps.getComponent<ChunkedPosition>(1));
+    REQUIRE(comps.getComponent<ChunkedName>(1)->name == "first");
+
+    REQUIRE(comps.deleteComponent<ChunkedName>(1));
+    REQUIRE(!comps.getComponent<ChunkedName>(1));
+}
+
+TEST_CASE("Deleting entity from the middle of archetype keeps other entities intact") {
+    ComponentManager comps;
+    const auto entityCount = 5000;  // spans several chunks
+
+    for (auto i = 1; i <= entityCount; i++) {
+        comps.addComponent<ChunkedPosition>(i, i);
+        comps.addComponent<ChunkedName>(i, std::to_string(i));
+    }
+
+    for (auto i = 1; i <= entityCount; i += 2) {
+        comps.deleteComponent<ChunkedName>(i);
+    }
+
+    for (auto i = 1; i <= entityCount; i++) {
+        REQUIRE(comps.getComponent<ChunkedPosition>(i)->x == i);
+        if (i % 2) {
+            REQUIRE(!comps.getComponent<ChunkedName>(i));
+        } else {
+            REQUIRE(comps.getComponent<ChunkedName>(i)->name == std::to_string(i));
+        }
+    }
+}
+
+TEST_CASE("Intersection walks archetype chunks and looks up other types") {
+    ComponentManager comps;
+
+    for (auto i = 1; i <= 300; i++) {
+        comps.addComponent<ChunkedPosition>(i, i);
+        if (i % 3 == 0) {
+            comps.addComponent<ChunkedName>(i, std::to_string(i));
+        }
+        if (i % 5 == 0) {
+            comps.addComponent<SortedTag>(i, i);
+        }
+    }
+
+    auto positions = comps.intersection<ChunkedPosition>();
+    REQUIRE(positions.size() == 300);
+
+    auto named = comps.intersection<ChunkedPosition, ChunkedName>();
+    REQUIRE(named.size() == 100);
+    for (auto& entity : named) {
+        REQUIRE(entity.get<ChunkedPosition>().x == (int)entity.entity());
+        REQUIRE(entity.get<ChunkedName>().name == std::to_string(entity.entity()));
+    }
+
+    // mixed query, SortedTag is looked up per entity
+    auto tagged = comps.intersection<ChunkedName, SortedTag, ChunkedPosition>();
+    REQUIRE(tagged.size() == 20);
+    for (auto& entity : tagged) {
+        REQUIRE((entity.entity() % 15) == 0);
+        REQUIRE(entity.get<SortedTag>().tag == entity.get<ChunkedPosition>().x);
+    }
+
+    // the same query driven by sorted container gives the same result
+    auto tagDriven = comps.intersection<SortedTag, ChunkedName, ChunkedPosition>();
+    REQUIRE(tagDriven.size() == 20);
+}
+
+TEST_CASE("View walks archetype chunks") {
+    ComponentManager comps;
+
+    // enough entities to fill several chunks, spread between archetypes {Position}, {Name} and {Position, Name}
+    for (auto i = 1u; i <= 3000; i++) {
+        if (i % 3 != 0) {
+            comps.addComponent<ChunkedPosition>(i, (int)i);
+        }
+        if (i % 2 == 0) {
+            comps.addComponent<ChunkedName>(i, std::to_string(i));
+        }
+    }
+
+    auto visited = 0u;
+    for (auto [entity, position, name] : comps.view<ChunkedPosition, ChunkedName>()) {
+        REQUIRE(position.x == (int)entity);
+        REQUIRE(name.name == std::to_string(entity));
+        REQUIRE((entity % 2 == 0 && entity % 3 != 0));
+        visited++;
+    }
+    REQUIRE(visited == 1000);
+
+    auto positions = 0u;
+    for ([[maybe_unused]] auto [entity, position] : comps.view<ChunkedPosition>()) {
+        positions++;
+    }
+    REQUIRE(positions == 2000);
+}
+
+TEST_CASE("Archetype storage works with EntityManager and handles") {
+    ComponentManager comps;
+    EntityManager entities(comps);
+    comps.setEntityManager(entities);
+
+    auto entity = entities.addEntity();
+    entity.addComponent<ChunkedPosition>(7);
+    entity.addComponent<ChunkedName>("seven");
+    entity.addComponent<SortedTag>(77);
+
+    auto handle = entity.componentHandle<ChunkedPosition>();
+    REQUIRE(handle->x == 7);
+
+    auto clone = entity.clone();
+    REQUIRE(clone.component<ChunkedPosition>()->x == 7);
+    REQUIRE(clone.component<ChunkedName>()->name == "seven");
+
+    // moving entity to other archetype invalidates raw pointer, but handle follows the component
+    auto rawPointer = entity.component<ChunkedPosition>();
+    entity.deleteComponent<ChunkedName>();
+    REQUIRE(!comps.validComponentPointer(rawPointer, entity));
+    REQUIRE(handle->x == 7);
+
+    REQUIRE(entities.deleteEntity(entity));
+    REQUIRE(!comps.getComponent<ChunkedPosition>(entity.getID()));
+    REQUIRE(!handle);
+    REQUIRE(clone.component<ChunkedName>()->name == "seven");
+
+    comps.clear();
+    REQUIRE(!clone.component<ChunkedName>());
+    REQUIRE(comps.intersection<ChunkedPosition>().empty());
+}
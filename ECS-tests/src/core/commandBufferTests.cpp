@@ -0,0 +1,84 @@
+#include <catch.hpp>
+#include "ecs/ecs.h"
+using namespace EECS;
+
+struct CommandedComponent : public Component<CommandedComponent> {
+    explicit CommandedComponent(int value = 0) : value(value) {}
+
+    int value = 0;
+};
+
+TEST_CASE("CommandBuffer defers structural changes until playback") {
+    ComponentManager components;
+    EntityManager entities{components};
+    components.setEntityManager(entities);
+    CommandBuffer commands{entities, components};
+
+    auto existing = entities.addEntity();
+    existing.addComponent<CommandedComponent>(1);
+    auto doomed = entities.addEntity();
+    doomed.addComponent<CommandedComponent>(2);
+    auto* pointer = existing.component<CommandedComponent>();
+
+    auto created = commands.addEntity();
+    commands.addComponent<CommandedComponent>(created, 3);
+    auto cloned = commands.addEntity(existing);
+    commands.deleteComponent<CommandedComponent>(existing);
+    commands.deleteEntity(doomed);
+
+    // nothing changes before playback, so pointers stay valid
+    REQUIRE_FALSE(commands.empty());
+    REQUIRE_FALSE(entities.entityExists(created));
+    REQUIRE(entities.entityExists(doomed));
+    REQUIRE(pointer == existing.component<CommandedComponent>());
+    REQUIRE(entities.size() == 2);
+
+    commands.playback();
+    REQUIRE(commands.empty());
+
+    REQUIRE(entities.entityExists(created));
+    REQUIRE(components.getComponent<CommandedComponent>(created)->value == 3);
+    REQUIRE(components.getComponent<CommandedComponent>(cloned)->value == 1);
+    REQUIRE_FALSE(existing.component<CommandedComponent>());
+    REQUIRE_FALSE(entities.entityExists(doomed));
+    REQUIRE(entities.size() == 3);
+
+    // index of deleted entity is reused by the next reservation
+    auto reused = commands.addEntity();
+    REQUIRE(entityIndex(reused) == entityIndex(doomed.getID()));
+    REQUIRE(reused != doomed.getID());
+    commands.playback();
+    REQUIRE(entities.entityExists(reused));
+}
+
+TEST_CASE("CommandBuffer records from many threads at once") {
+    ComponentManager components;
+    EntityManager entities{components};
+    components.setEntityManager(entities);
+    CommandBuffer commands{entities, components};
+
+    ThreadPool pool(4);
+    commands.setThreadCount(pool.size());
+
+    // half of the entities are created from the free list, half from new indices
+    auto recycled = entities.spawnBatch(500);
+    entities.destroyBatch(recycled);
+
+    pool.run(1000, [&](size_t job, size_t) {
+        auto entity = commands.addEntity();
+        commands.addComponent<CommandedComponent>(entity, (int)job);
+    });
+    commands.playback();
+
+    REQUIRE(entities.size() == 1000);
+    auto& all = components.getAllComponents<CommandedComponent>();
+    REQUIRE(all.size() == 1000);
+
+    std::vector<int> seen(1000);
+    for (auto& component : all) {
+        seen[component.value]++;
+    }
+    for (auto count : seen) {
+        REQUIRE(count == 1);
+    }
+}
@@ -120,3 +120,51 @@ TEST_CASE("Getting new class instance works") {
     REQUIRE(newContainer.get() != nullptr);
     REQUIRE(newContainer.get() != &originalContainer);
 }
+
+struct SparseComponent : public Component<SparseComponent> {
+    static constexpr ComponentStorage storage = ComponentStorage::SparseSet;
+
+    SparseComponent(int init = 0) : foo(init) {}
+
+    int foo = 0;
+};
+
+TEST_CASE("SparseSet storage adds, gets and deletes components") {
+    ComponentContainer<SparseComponent> comps;
+
+    REQUIRE(comps.addComponent(0) == nullptr);
+
+    comps.addComponent(5, 555);
+    comps.addComponent(1, 111);
+    comps.addComponent(100000, 999);
+
+    REQUIRE(comps.getComponent(5)->foo == 555);
+    REQUIRE(comps.getComponent(1)->foo == 111);
+    REQUIRE(comps.getComponent(100000)->foo == 999);
+    REQUIRE(comps.getComponent(2) == nullptr);
+
+    // adding again replaces existing component
+    comps.addComponent(1, 112);
+    REQUIRE(comps.getComponent(1)->foo == 112);
+    REQUIRE(comps.getAllComponents().size() == 3);
+
+    // deleting from the middle moves last component into the hole, it stays accessible
+    REQUIRE(comps.deleteComponent(5));
+    REQUIRE(!comps.deleteComponent(5));
+    REQUIRE(comps.getComponent(5) == nullptr);
+    REQUIRE(comps.getComponent(1)->foo == 112);
+    REQUIRE(comps.getComponent(100000)->foo == 999);
+
+    // remaining components are still packed
+    REQUIRE(comps.getAllComponents().size() == 2);
+    for (auto& component : comps.getAllComponents()) {
+        REQUIRE(comps.getComponent(component.entityID) == &component);
+    }
+
+    REQUIRE(comps.cloneComponent(1, 7));
+    REQUIRE(comps.getComponent(7)->foo == 112);
+
+    comps.clear();
+    REQUIRE(comps.getComponent(1) == nullptr);
+    REQUIRE(comps.getAllComponents().empty());
+}
@@ -0,0 +1,184 @@
+#include <catch.hpp>
+#include <vector>
+#include "ecs/ecs.h"
+using namespace EECS;
+
+struct ObservedComponent : public Component<ObservedComponent> {
+    explicit ObservedComponent(int value = 0) : value(value) {}
+
+    int value = 0;
+};
+
+struct ObservedChunkComponent : public Component<ObservedChunkComponent> {
+    static constexpr ComponentStorage storage = ComponentStorage::Archetype;
+    int value = 0;
+};
+
+struct BaseComponent : public Component<BaseComponent> {
+    int value = 0;
+};
+
+struct MiddleComponent : public Component<MiddleComponent> {
+    static constexpr ComponentStorage storage = ComponentStorage::Archetype;
+    int value = 0;
+};
+
+struct TopComponent : public Component<TopComponent> {
+    static constexpr ComponentStorage storage = ComponentStorage::SparseSet;
+    int value = 0;
+};
+
+Depends<MiddleComponent, BaseComponent> middleDependencies;
+Depends<TopComponent, MiddleComponent> topDependencies;
+
+TEST_CASE("Observers are notified about changes of components") {
+    ComponentManager components;
+    EntityManager entities{components};
+    components.setEntityManager(entities);
+
+    std::vector<std::pair<EntityID, int>> added, replaced, removed;
+    components.observe<ObservedComponent>(ComponentChange::Added, [&](EntityID entity, ObservedComponent& component) {
+        added.push_back({entity, component.value});
+    });
+    components.observe<ObservedComponent>(ComponentChange::Replaced,
+                                          [&](EntityID entity, ObservedComponent& component) {
+                                              replaced.push_back({entity, component.value});
+                                          });
+    auto removalObserver = components.observe<ObservedComponent>(
+        ComponentChange::Removed, [&](EntityID entity, ObservedComponent& component) {
+            removed.push_back({entity, component.value});
+        });
+
+    auto entity = entities.addEntity();
+    entity.addComponent<ObservedComponent>(1);
+    entity.addComponent<ObservedComponent>(2);
+    REQUIRE((added == std::vector<std::pair<EntityID, int>>{{entity, 1}}));
+    REQUIRE((replaced == std::vector<std::pair<EntityID, int>>{{entity, 2}}));
+
+    // removal is reported before component is deleted, and only if it existed
+    entity.deleteComponent<ObservedComponent>();
+    entity.deleteComponent<ObservedComponent>();
+    REQUIRE((removed == std::vector<std::pair<EntityID, int>>{{entity, 2}}));
+
+    // cloned and deleted entities are reported too
+    entity.addComponent<ObservedComponent>(3);
+    auto spawned = entities.spawnBatch(2, entity);
+    REQUIRE(added.size() == 4);
+    entities.destroyBatch(spawned);
+    entity.deleteEntity();
+    REQUIRE(removed.size() == 4);
+
+    REQUIRE(components.unobserve<ObservedComponent>(removalObserver));
+    REQUIRE_FALSE(components.unobserve<ObservedComponent>(removalObserver));
+    entities.addEntity().addComponent<ObservedComponent>(4);
+    components.clear();
+    REQUIRE(removed.size() == 4);
+}
+
+TEST_CASE("Observers of Archetype-stored components are notified when entity is deleted") {
+    ComponentManager components;
+    EntityManager entities{components};
+    components.setEntityManager(entities);
+
+    auto removed = 0;
+    components.observe<ObservedChunkComponent>(ComponentChange::Removed,
+                                               [&](EntityID, ObservedChunkComponent& component) {
+                                                   removed += component.value;
+                                               });
+
+    auto first = entities.addEntity();
+    first.addComponent<ObservedChunkComponent>()->value = 1;
+    auto second = entities.addEntity();
+    second.addComponent<ObservedChunkComponent>()->value = 10;
+    auto third = entities.addEntity();
+    third.addComponent<ObservedChunkComponent>()->value = 100;
+
+    first.deleteEntity();
+    REQUIRE(removed == 1);
+    std::vector<EntityID> rest = {second, third};
+    entities.destroyBatch(rest);
+    REQUIRE(removed == 111);
+}
+
+TEST_CASE("Dependencies are kept by observers") {
+    ComponentManager components;
+    EntityManager entities{components};
+    components.setEntityManager(entities);
+
+    // adding component adds its dependencies, recursively
+    auto entity = entities.addEntity();
+    REQUIRE(entity.addComponent<TopComponent>());
+    REQUIRE(entity.component<MiddleComponent>());
+    REQUIRE(entity.component<BaseComponent>());
+    REQUIRE(components.hasDependentComponents<BaseComponent>(entity));
+    REQUIRE(components.hasDependentComponents<MiddleComponent>(entity));
+    REQUIRE_FALSE(components.hasDependentComponents<TopComponent>(entity));
+
+    // existing dependencies are kept
+    auto other = entities.addEntity();
+    other.addComponent<BaseComponent>()->value = 5;
+    other.addComponent<MiddleComponent>();
+    REQUIRE(other.component<BaseComponent>()->value == 5);
+
+    // deleting component deletes components which depend on it, recursively
+    entity.deleteComponent<BaseComponent>();
+    REQUIRE_FALSE(entity.component<MiddleComponent>());
+    REQUIRE_FALSE(entity.component<TopComponent>());
+    REQUIRE(other.component<MiddleComponent>());
+
+    other.deleteComponent<MiddleComponent>();
+    REQUIRE(other.component<BaseComponent>());
+
+    entity.addComponent<TopComponent>();
+    entity.deleteEntity();
+    REQUIRE(components.getAllComponents<TopComponent>().empty());
+    REQUIRE(components.getAllComponents<BaseComponent>().size() == 1);
+}
+
+TEST_CASE("Cloned entities get dependencies of prototype") {
+    ComponentManager components;
+    EntityManager entities{components};
+    components.setEntityManager(entities);
+
+    std::vector<int> added;
+    components.observe<TopComponent>(ComponentChange::Added,
+                                     [&](EntityID, TopComponent& component) { added.push_back(component.value); });
+
+    auto prototype = entities.addEntity();
+    prototype.addComponent<TopComponent>()->value = 7;
+    prototype.component<MiddleComponent>()->value = 6;
+    prototype.component<BaseComponent>()->value = 5;
+    added.clear();
+
+    auto spawned = entities.spawnBatch(4, prototype);
+    REQUIRE(components.getAllComponents<BaseComponent>().size() == 5);
+    REQUIRE(components.getAllComponents<TopComponent>().size() == 5);
+    for (auto entity : spawned) {
+        REQUIRE(components.getComponent<const BaseComponent>(entity)->value == 5);
+        REQUIRE(components.getComponent<const MiddleComponent>(entity)->value == 6);
+        REQUIRE(components.getComponent<const TopComponent>(entity)->value == 7);
+    }
+
+    // observers get cloned values, also when single entity is cloned
+    auto clone = prototype.clone();
+    REQUIRE(clone.component<BaseComponent>()->value == 5);
+    REQUIRE(components.getAllComponents<BaseComponent>().size() == 6);
+    REQUIRE((added == std::vector<int>{7, 7, 7, 7, 7}));
+
+    // deleting dependency of spawned entity still deletes its dependents
+    components.deleteComponent<BaseComponent>(spawned[0]);
+    REQUIRE_FALSE(components.getComponent<const TopComponent>(spawned[0]));
+    REQUIRE(components.getAllComponents<TopComponent>().size() == 5);
+}
+
+TEST_CASE("Cyclic dependencies are rejected") {
+    auto base = ComponentContainerID::get<BaseComponent>();
+    auto top = ComponentContainerID::get<TopComponent>();
+
+    // top depends on base through middle
+    REQUIRE(componentDependsOn(top, base));
+    REQUIRE_FALSE(componentDependsOn(base, top));
+    REQUIRE_FALSE(addComponentDependency(base, top));
+    REQUIRE_FALSE(addComponentDependency(base, base));
+    REQUIRE_FALSE(componentDependsOn(base, top));
+}
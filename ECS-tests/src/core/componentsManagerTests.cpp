@@ -1,4 +1,6 @@
 #include <catch.hpp>
+#include <algorithm>
+#include <thread>
 #include "ecs/ecs.h"
 using namespace EECS;
 
@@ -125,6 +127,157 @@ TEST_CASE("Intersection method test - multithreading") {
     REQUIRE(intersection.size() == 100);
 }
 
+TEST_CASE("View method test") {
+    ComponentManager comps;
+
+    // entities 1 and 2 have both components, 3 has only FooComponent, 4 and 5 have only BarComponent
+    comps.addComponent<FooComponent>(1, 11);
+    comps.addComponent<BarComponent>(1, 12);
+    comps.addComponent<FooComponent>(2, 21);
+    comps.addComponent<BarComponent>(2, 22);
+    comps.addComponent<FooComponent>(3, 31);
+    comps.addComponent<BarComponent>(4, 42);
+    comps.addComponent<BarComponent>(5, 52);
+
+    // FooComponent container is smaller, so it drives iteration and there are no more candidates than it has
+    auto both = comps.view<BarComponent, FooComponent>();
+    REQUIRE(both.sizeHint() == 3);
+
+    auto visited = std::vector<EntityID>{};
+    for (auto [entity, bar, foo] : both) {
+        visited.push_back(entity);
+        REQUIRE(foo.foo == (int)entity * 10 + 1);
+        REQUIRE(bar.bar == (int)entity * 10 + 2);
+
+        // components are accessed by reference
+        foo.foo = 666;
+    }
+
+    auto expected = std::vector<EntityID>{1, 2};
+    REQUIRE(visited == expected);
+    REQUIRE(comps.getComponent<FooComponent>(1)->foo == 666);
+    REQUIRE(comps.getComponent<FooComponent>(2)->foo == 666);
+    REQUIRE(comps.getComponent<FooComponent>(3)->foo == 31);
+
+    // view could be iterated more than once
+    auto count = 0;
+    for ([[maybe_unused]] auto element : both) {
+        count++;
+    }
+    REQUIRE(count == 2);
+}
+
+struct ChunkedBazComponent : public Component<ChunkedBazComponent> {
+    static constexpr ComponentStorage storage = ComponentStorage::Archetype;
+    int baz = 0;
+};
+
+TEST_CASE("View filters by change ticks") {
+    ComponentManager comps;
+
+    for (auto entity = EntityID{1}; entity <= 4; entity++) {
+        comps.addComponent<FooComponent>(entity, (int)entity);
+        comps.addComponent<BarComponent>(entity, (int)entity);
+        comps.addComponent<ChunkedBazComponent>(entity);
+    }
+
+    auto visitedEntities = [](auto&& view) {
+        auto visited = std::vector<EntityID>{};
+        for (auto element : view) {
+            visited.push_back(std::get<0>(element));
+        }
+        std::sort(visited.begin(), visited.end());
+        return visited;
+    };
+
+    // everything was added in the first tick
+    auto since = comps.tick();
+    REQUIRE(visitedEntities(comps.view<Added<const FooComponent>>(since - 1)).size() == 4);
+    comps.advanceTick();
+    REQUIRE(visitedEntities(comps.view<Changed<const FooComponent>>(since)).empty());
+    REQUIRE(visitedEntities(comps.view<Changed<const ChunkedBazComponent>>(since)).empty());
+
+    // const access doesn't stamp anything
+    for (auto [entity, foo, bar] : comps.view<const FooComponent, const BarComponent>()) {
+        (void)foo;
+        (void)bar;
+    }
+    comps.getComponent<const FooComponent>(1);
+    REQUIRE(visitedEntities(comps.view<Changed<const FooComponent>>(since)).empty());
+
+    // neither does testing a handle, only dereferencing it
+    auto handle = comps.getComponentHandle<FooComponent>(1);
+    REQUIRE(handle);
+    REQUIRE((FooComponent*)handle);
+    REQUIRE(visitedEntities(comps.view<Changed<const FooComponent>>(since)).empty());
+    REQUIRE(handle->foo == 1);
+    REQUIRE((visitedEntities(comps.view<Changed<const FooComponent>>(since)) == std::vector<EntityID>{1}));
+
+    comps.getComponent<FooComponent>(2)->foo = 20;
+    comps.getComponent<ChunkedBazComponent>(3)->baz = 30;
+    for (auto [entity, bar] : comps.view<BarComponent>()) {
+        bar.bar = 0;
+    }
+    comps.addComponent<FooComponent>(5);
+    comps.addComponent<BarComponent>(5);
+
+    REQUIRE((visitedEntities(comps.view<Changed<const FooComponent>>(since)) == std::vector<EntityID>{1, 2, 5}));
+    REQUIRE((visitedEntities(comps.view<Added<FooComponent>, const BarComponent>(since)) == std::vector<EntityID>{5}));
+    REQUIRE((visitedEntities(comps.view<Changed<const ChunkedBazComponent>>(since)) == std::vector<EntityID>{3}));
+    REQUIRE(visitedEntities(comps.view<Changed<const BarComponent>>(since)).size() == 5);
+
+    // Added<FooComponent> stamped entity 5 as changed again, but in the same tick
+    comps.advanceTick();
+    REQUIRE(visitedEntities(comps.view<Changed<const FooComponent>>(comps.tick() - 1)).empty());
+}
+
+TEST_CASE("View of empty containers") {
+    ComponentManager comps;
+
+    comps.addComponent<FooComponent>(1);
+
+    auto empty = comps.view<FooComponent, BarComponent>();
+    REQUIRE(empty.sizeHint() == 0);
+    auto nothingVisited = empty.begin() == empty.end();
+    REQUIRE(nothingVisited);
+}
+
+TEST_CASE("parallelForEach method test") {
+    ComponentManager comps;
+    ThreadPool pool(4);
+    comps.setThreadPool(pool);
+    comps.setParallelThreshold(1000);
+
+    // 10000 entities with both types, so that work is split between threads, and 5000 with only FooComponent
+    for (auto i = 1; i <= 15000; i++) {
+        comps.addComponent<FooComponent>(i, i);
+        if (i <= 10000) {
+            comps.addComponent<BarComponent>(i);
+        }
+    }
+
+    comps.parallelForEach<FooComponent, BarComponent>([](EntityID, FooComponent& foo, BarComponent& bar) {
+        bar.bar = foo.foo * 2;
+    });
+
+    for (auto i = 1; i <= 10000; i++) {
+        REQUIRE(comps.getComponent<BarComponent>(i)->bar == i * 2);
+    }
+
+    // intersection is gathered in parallel too
+    auto both = comps.intersection<FooComponent, BarComponent>();
+    REQUIRE(both.size() == 10000);
+
+    // below threshold, everything runs on calling thread
+    comps.setParallelThreshold(100000);
+    auto caller = std::this_thread::get_id();
+    auto allOnCaller = true;
+    comps.parallelForEach<FooComponent>([&](EntityID, FooComponent&) {
+        allOnCaller = allOnCaller && std::this_thread::get_id() == caller;
+    });
+    REQUIRE(allOnCaller);
+}
+
 TEST_CASE("Component handles test") {
     ComponentManager comps;
 
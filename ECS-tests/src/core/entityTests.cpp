@@ -1,4 +1,5 @@
 #include <catch.hpp>
+#include <algorithm>
 #include "ecs/ecs.h"
 using namespace EECS;
 
@@ -8,6 +9,16 @@ struct FooComponent : public Component<FooComponent> {
     int foo = 0;
 };
 
+struct SparseFooComponent : public Component<SparseFooComponent> {
+    static constexpr ComponentStorage storage = ComponentStorage::SparseSet;
+    int foo = 0;
+};
+
+struct ChunkedFooComponent : public Component<ChunkedFooComponent> {
+    static constexpr ComponentStorage storage = ComponentStorage::Archetype;
+    int foo = 0;
+};
+
 TEST_CASE("Entity class works") {
     ComponentManager components;
     EntityManager entities{components};
@@ -48,3 +59,106 @@ TEST_CASE("Entity class works") {
     entity.deleteComponent<FooComponent>();
     REQUIRE_FALSE(entity.component<FooComponent>());
 }
+
+TEST_CASE("Deleted entity IDs are recycled with new generation") {
+    ComponentManager components;
+    EntityManager entities{components};
+    components.setEntityManager(entities);
+
+    auto first = entities.addEntity();
+    first.addComponent<FooComponent>(1);
+    first.addComponent<SparseFooComponent>()->foo = 1;
+    first.addComponent<ChunkedFooComponent>()->foo = 1;
+    auto handle = first.componentHandle<FooComponent>();
+    auto staleID = first.getID();
+    Entity stale{staleID, entities, components};
+
+    first.deleteEntity();
+    REQUIRE(entities.size() == 0);
+
+    // index is reused, but ID differs
+    auto second = entities.addEntity();
+    second.addComponent<FooComponent>(2);
+    second.addComponent<SparseFooComponent>()->foo = 2;
+    second.addComponent<ChunkedFooComponent>()->foo = 2;
+    REQUIRE(entityIndex(second.getID()) == entityIndex(staleID));
+    REQUIRE(entityGeneration(second.getID()) == entityGeneration(staleID) + 1);
+    REQUIRE(second.getID() != staleID);
+
+    // stale IDs don't refer to the new entity
+    REQUIRE(second.exists());
+    REQUIRE_FALSE(stale.exists());
+    REQUIRE_FALSE(entities.entityExists(staleID));
+    REQUIRE_FALSE(handle);
+    REQUIRE_FALSE(stale.component<FooComponent>());
+    REQUIRE_FALSE(stale.component<SparseFooComponent>());
+    REQUIRE_FALSE(stale.component<ChunkedFooComponent>());
+    REQUIRE_FALSE(stale.addComponent<FooComponent>(3));
+    REQUIRE_FALSE(stale.deleteComponent<SparseFooComponent>());
+    REQUIRE_FALSE(stale.deleteComponent<ChunkedFooComponent>());
+    REQUIRE_FALSE(entities.deleteEntity(staleID));
+
+    REQUIRE(second.component<FooComponent>()->foo == 2);
+    REQUIRE(second.component<SparseFooComponent>()->foo == 2);
+    REQUIRE(second.component<ChunkedFooComponent>()->foo == 2);
+
+    // new indices are taken only when there are no free ones
+    auto third = entities.addEntity();
+    REQUIRE(entityIndex(third.getID()) != entityIndex(second.getID()));
+    REQUIRE(entities.size() == 2);
+
+    entities.clear();
+    REQUIRE(entities.size() == 0);
+    REQUIRE_FALSE(second.exists());
+    REQUIRE_FALSE(third.exists());
+}
+
+TEST_CASE("Entities can be spawned and destroyed in batches") {
+    ComponentManager components;
+    EntityManager entities{components};
+    components.setEntityManager(entities);
+
+    auto prototype = entities.addEntity();
+    prototype.addComponent<FooComponent>(7);
+    prototype.addComponent<SparseFooComponent>()->foo = 8;
+    prototype.addComponent<ChunkedFooComponent>()->foo = 9;
+
+    auto spawned = entities.spawnBatch(100, prototype);
+    REQUIRE(spawned.size() == 100);
+    REQUIRE(entities.size() == 101);
+    REQUIRE(std::is_sorted(spawned.begin(), spawned.end()));
+    for (auto entity : spawned) {
+        REQUIRE(components.getComponent<FooComponent>(entity)->foo == 7);
+        REQUIRE(components.getComponent<SparseFooComponent>(entity)->foo == 8);
+        REQUIRE(components.getComponent<ChunkedFooComponent>(entity)->foo == 9);
+    }
+
+    // sorted container stays sorted
+    auto& foos = components.getAllComponents<FooComponent>();
+    auto sorted = std::is_sorted(foos.begin(), foos.end(),
+                                 [](const auto& a, const auto& b) { return a.entityID < b.entityID; });
+    REQUIRE(sorted);
+
+    // every other entity is destroyed, along with one which is already gone and a duplicate
+    std::vector<EntityID> destroyed;
+    for (auto i = 0u; i < spawned.size(); i += 2) {
+        destroyed.push_back(spawned[i]);
+    }
+    destroyed.push_back(spawned[0]);
+    REQUIRE(entities.deleteEntity(spawned[2]));
+    REQUIRE(entities.destroyBatch(destroyed) == 49);
+
+    REQUIRE(entities.size() == 51);
+    REQUIRE(foos.size() == 51);
+    for (auto i = 0u; i < spawned.size(); i++) {
+        REQUIRE(entities.entityExists(spawned[i]) == (i % 2 == 1));
+        REQUIRE((components.getComponent<SparseFooComponent>(spawned[i]) != nullptr) == (i % 2 == 1));
+        REQUIRE((components.getComponent<ChunkedFooComponent>(spawned[i]) != nullptr) == (i % 2 == 1));
+    }
+    REQUIRE(prototype.component<FooComponent>()->foo == 7);
+
+    // batch without prototype has no components
+    auto empty = entities.spawnBatch(3);
+    REQUIRE(empty.size() == 3);
+    REQUIRE_FALSE(components.getComponent<FooComponent>(empty[0]));
+}
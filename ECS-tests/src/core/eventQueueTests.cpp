@@ -1,4 +1,7 @@
 #include <catch.hpp>
+#include <array>
+#include <span>
+#include <vector>
 #include "ecs/ecs.h"
 using namespace EECS;
 
@@ -128,3 +131,258 @@ TEST_CASE("Priority system works") {
     REQUIRE(aReceiver.lastEvent == 6);
     REQUIRE(bReceiver.lastEvent == 3);
 }
+
+struct ProducedEvent : Event<ProducedEvent> {
+    ProducedEvent(size_t producer, size_t sequence) : producer(producer), sequence(sequence) {}
+
+    size_t producer;
+    size_t sequence;
+};
+
+struct ProducedEventReceiver : Receives<ProducedEventReceiver, ProducedEvent> {
+    ProducedEventReceiver(EventQueue& ev) : Receives(ev) {}
+
+    bool receive(ProducedEvent& event) {
+        received.push_back(event);
+        return true;
+    }
+
+    std::vector<ProducedEvent> received;
+};
+
+TEST_CASE("Events pushed from many threads", "[EventQueue]") {
+    ThreadPool pool(4);
+    EventQueue events;
+    events.setThreadCount(pool.size());
+    ProducedEventReceiver receiver(events);
+
+    // every job pushes a few events, each thread numbers its events in order of pushing
+    std::vector<size_t> pushed(pool.size());
+    pool.run(1000, [&](size_t, size_t) {
+        auto thread = ThreadPool::currentThread();
+        for (auto i = 0; i < 3; i++) {
+            events.emplace<ProducedEvent>(thread, pushed[thread]++);
+        }
+    });
+    events.emit();
+
+    REQUIRE(receiver.received.size() == 3000);
+    std::vector<size_t> next(pool.size());
+    for (const auto& event : receiver.received) {
+        REQUIRE(event.sequence == next[event.producer]++);
+    }
+    REQUIRE(next == pushed);
+
+    receiver.received.clear();
+    events.emit();
+    REQUIRE(receiver.received.empty());
+}
+
+struct AEventBatchReceiver : Receives<AEventBatchReceiver, AEvent> {
+    AEventBatchReceiver(EventQueue& ev) : Receives(ev) {}
+
+    bool receive(std::span<AEvent> events) {
+        batches.emplace_back();
+        for (auto& event : events) {
+            batches.back().push_back(event.x);
+        }
+        return passFurther;
+    }
+
+    std::vector<std::vector<int>> batches;
+    bool passFurther = true;
+};
+
+struct OddConsumer : Receives<OddConsumer, AEvent> {
+    OddConsumer(EventQueue& ev) : Receives(ev) {}
+
+    bool receive(AEvent& event) { return event.x % 2 == 0; }
+};
+
+TEST_CASE("Batch receiver gets events which weren't consumed in one call", "[EventQueue]") {
+    EventQueue events;
+    AEventBatchReceiver batchReceiver(events);
+    OddConsumer consumer(events);
+    Receiver receiver(events);
+
+    events.setPriority<AEvent>(consumer, 0);
+    events.setPriority<AEvent>(batchReceiver, 1);
+    events.setPriority<AEvent>(receiver, 2);
+
+    for (auto i = 0; i < 6; i++) {
+        events.emplace<AEvent>(i);
+    }
+    events.emit();
+    REQUIRE((batchReceiver.batches == std::vector<std::vector<int>>{{0, 2, 4}}));
+    REQUIRE(receiver.lastAEvent == 4);
+
+    // batch receiver consumes whole batch
+    batchReceiver.passFurther = false;
+    events.emplace<AEvent>(8);
+    events.emit();
+    REQUIRE(batchReceiver.batches.size() == 2);
+    REQUIRE(receiver.lastAEvent == 4);
+
+    // it isn't called when there's nothing left to receive
+    events.emplace<AEvent>(1);
+    events.emit();
+    REQUIRE(batchReceiver.batches.size() == 2);
+}
+
+// records order in which receivers get events, as receiver * 100 + event
+struct OrderReceiver : Receives<OrderReceiver, AEvent> {
+    OrderReceiver(EventQueue& ev, std::vector<int>& log, int id) : Receives(ev), log(log), id(id) {}
+
+    bool receive(AEvent& event) {
+        log.push_back(id * 100 + event.x);
+        return true;
+    }
+
+    std::vector<int>& log;
+    int id;
+};
+
+TEST_CASE("Events go through all receivers one by one, unless batch receiver is connected", "[EventQueue]") {
+    EventQueue events;
+    std::vector<int> log;
+    OrderReceiver first(events, log, 1);
+    OrderReceiver second(events, log, 2);
+    events.setPriority<AEvent>(first, 0);
+    events.setPriority<AEvent>(second, 1);
+
+    events.emplace<AEvent>(1);
+    events.emplace<AEvent>(2);
+    events.emit();
+    REQUIRE((log == std::vector<int>{101, 201, 102, 202}));
+
+    // each receiver gets all events before the next one
+    log.clear();
+    AEventBatchReceiver batchReceiver(events);
+    events.emplace<AEvent>(1);
+    events.emplace<AEvent>(2);
+    events.emit();
+    REQUIRE((log == std::vector<int>{101, 102, 201, 202}));
+}
+
+// consumes odd events of a batch, like OddConsumer does one by one
+struct OddBatchConsumer : Receives<OddBatchConsumer, AEvent> {
+    OddBatchConsumer(EventQueue& ev) : Receives(ev) {}
+
+    size_t receive(std::span<AEvent> events) {
+        auto kept = size_t{0};
+        for (auto& event : events) {
+            if (event.x % 2 == 0) {
+                events[kept++] = event;
+            }
+        }
+        return kept;
+    }
+};
+
+TEST_CASE("Batch receiver can consume single events", "[EventQueue]") {
+    EventQueue events;
+    OddBatchConsumer consumer(events);
+    AEventBatchReceiver batchReceiver(events);
+    events.setPriority<AEvent>(consumer, 0);
+    events.setPriority<AEvent>(batchReceiver, 1);
+
+    for (auto i = 0; i < 6; i++) {
+        events.emplace<AEvent>(i);
+    }
+    events.emit();
+    REQUIRE((batchReceiver.batches == std::vector<std::vector<int>>{{0, 2, 4}}));
+}
+
+struct ChainingReceiver : Receives<ChainingReceiver, AEvent> {
+    ChainingReceiver(EventQueue& ev) : Receives(ev), events(ev) {}
+
+    bool receive(AEvent& event) {
+        received.push_back(event.x);
+        if (event.x > 0) {
+            events.emplace<AEvent>(event.x - 1);
+        }
+        return true;
+    }
+
+    EventQueue& events;
+    std::vector<int> received;
+};
+
+TEST_CASE("Events pushed while emitting are received on next emit", "[EventQueue]") {
+    EventQueue events;
+    ChainingReceiver receiver(events);
+
+    events.emplace<AEvent>(2);
+    events.emplace<AEvent>(1);
+    events.emit();
+    REQUIRE((receiver.received == std::vector<int>{2, 1}));
+
+    events.emit();
+    REQUIRE((receiver.received == std::vector<int>{2, 1, 1, 0}));
+
+    events.emit();
+    events.emit();
+    REQUIRE((receiver.received == std::vector<int>{2, 1, 1, 0, 0}));
+}
+
+struct ContactEvent : Event<ContactEvent> {
+    ContactEvent(EntityID first, EntityID second) : first(first), second(second) {}
+
+    std::array<EntityID, 2> entities() const { return {first, second}; }
+
+    EntityID first;
+    EntityID second;
+};
+
+struct ContactReceiver {
+    bool receive(ContactEvent& event) {
+        received.push_back(event.entities());
+        return spreads;
+    }
+
+    std::vector<std::array<EntityID, 2>> received;
+    bool spreads = true;
+};
+
+TEST_CASE("Receivers subscribed to entity get only its events", "[EventQueue]") {
+    EventQueue events;
+    ContactReceiver first, second, all;
+    events.connect<ContactEvent>(first, EntityID{1});
+    events.connect<ContactEvent>(first, EntityID{2});
+    events.connect<ContactEvent>(second, EntityID{2}, 1);
+    events.connect<ContactEvent>(all);
+
+    events.emplace<ContactEvent>(1, 2);
+    events.emplace<ContactEvent>(3, 4);
+    events.emplace<ContactEvent>(4, 2);
+    events.emit();
+
+    // receiver subscribed to both entities of an event gets it once
+    REQUIRE((first.received == std::vector<std::array<EntityID, 2>>{{1, 2}, {4, 2}}));
+    REQUIRE((second.received == std::vector<std::array<EntityID, 2>>{{1, 2}, {4, 2}}));
+    REQUIRE(all.received.size() == 3);
+
+    // subscribed receivers are called before others, in order of priority
+    first.spreads = false;
+    events.emplace<ContactEvent>(2, 5);
+    events.emplace<ContactEvent>(5, 6);
+    events.emit();
+    REQUIRE(second.received.size() == 2);
+    REQUIRE((all.received.back() == std::array<EntityID, 2>{5, 6}));
+    REQUIRE(all.received.size() == 4);
+
+    events.disconnect<ContactEvent>(first, EntityID{2});
+    events.setPriority<ContactEvent>(all, 5);
+    events.emplace<ContactEvent>(2, 5);
+    events.emit();
+    REQUIRE(first.received.size() == 3);
+    REQUIRE(second.received.size() == 3);
+    REQUIRE(all.received.size() == 5);
+
+    events.disconnect<ContactEvent>(second);
+    events.emplace<ContactEvent>(1, 2);
+    events.emit();
+    REQUIRE(first.received.size() == 4);
+    REQUIRE(second.received.size() == 3);
+    REQUIRE(all.received.size() == 5);
+}
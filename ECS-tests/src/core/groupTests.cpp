@@ -0,0 +1,157 @@
+#include <catch.hpp>
+#include <algorithm>
+#include "ecs/ecs.h"
+using namespace EECS;
+
+struct GroupedComponent : public Component<GroupedComponent> {
+    int value = 0;
+};
+
+struct GroupedChunkComponent : public Component<GroupedChunkComponent> {
+    static constexpr ComponentStorage storage = ComponentStorage::Archetype;
+    int value = 0;
+};
+
+struct OwnedComponent : public Component<OwnedComponent> {
+    static constexpr ComponentStorage storage = ComponentStorage::SparseSet;
+    int value = 0;
+};
+
+struct OtherOwnedComponent : public Component<OtherOwnedComponent> {
+    static constexpr ComponentStorage storage = ComponentStorage::SparseSet;
+    int value = 0;
+};
+
+namespace {
+template <class GroupType>
+std::vector<EntityID> membersOf(const GroupType& group) {
+    std::vector<EntityID> members;
+    for (auto components : group) {
+        members.push_back(std::get<0>(components));
+    }
+    std::sort(members.begin(), members.end());
+    return members;
+}
+}
+
+TEST_CASE("Group keeps track of matching entities") {
+    ComponentManager components;
+    EntityManager entities{components};
+    components.setEntityManager(entities);
+
+    auto before = entities.addEntity();
+    before.addComponent<GroupedComponent>()->value = 1;
+    before.addComponent<GroupedChunkComponent>()->value = 1;
+    auto partial = entities.addEntity();
+    partial.addComponent<GroupedComponent>();
+
+    // entities which matched before group was created are its members
+    auto& group = components.group<GroupedComponent, GroupedChunkComponent>();
+    REQUIRE((&group == &components.group<GroupedComponent, GroupedChunkComponent>()));
+    REQUIRE(membersOf(group) == std::vector<EntityID>{before});
+
+    auto after = entities.addEntity();
+    after.addComponent<GroupedChunkComponent>()->value = 2;
+    REQUIRE_FALSE(group.contains(after));
+    after.addComponent<GroupedComponent>()->value = 2;
+    REQUIRE((membersOf(group) == std::vector<EntityID>{before, after}));
+
+    for (auto [entity, grouped, chunk] : group) {
+        REQUIRE(grouped.value == chunk.value);
+        REQUIRE(grouped.entityID == entity);
+    }
+
+    SECTION("deleting component removes entity") {
+        before.deleteComponent<GroupedChunkComponent>();
+        REQUIRE(membersOf(group) == std::vector<EntityID>{after});
+        partial.addComponent<GroupedChunkComponent>();
+        REQUIRE((membersOf(group) == std::vector<EntityID>{partial, after}));
+    }
+
+    SECTION("deleting entity removes it") {
+        before.deleteEntity();
+        REQUIRE(membersOf(group) == std::vector<EntityID>{after});
+
+        std::vector<EntityID> doomed = {after, partial};
+        entities.destroyBatch(doomed);
+        REQUIRE(group.empty());
+    }
+
+    SECTION("spawned entities join it") {
+        auto spawned = entities.spawnBatch(3, after);
+        REQUIRE(group.size() == 5);
+        for (auto entity : spawned) {
+            REQUIRE(group.contains(entity));
+        }
+    }
+
+    SECTION("clearing components empties it") {
+        components.clear<GroupedComponent>();
+        REQUIRE(group.empty());
+        REQUIRE_FALSE(group.contains(before));
+    }
+}
+
+TEST_CASE("Owning group keeps its members packed at the front of containers") {
+    ComponentManager components;
+    EntityManager entities{components};
+    components.setEntityManager(entities);
+
+    std::vector<EntityID> all;
+    for (auto i = 0; i < 10; i++) {
+        auto entity = entities.addEntity();
+        entity.addComponent<OwnedComponent>()->value = i;
+        if (i % 2 == 0) {
+            entity.addComponent<OtherOwnedComponent>()->value = i;
+        }
+        all.push_back(entity);
+    }
+
+    auto* group = components.owningGroup<OwnedComponent, OtherOwnedComponent>();
+    REQUIRE(group);
+    REQUIRE((group == components.owningGroup<OwnedComponent, OtherOwnedComponent>()));
+    REQUIRE_FALSE(components.owningGroup<OtherOwnedComponent>());
+
+    auto requirePacked = [&] {
+        auto& owned = components.getAllComponents<OwnedComponent>();
+        auto& other = components.getAllComponents<OtherOwnedComponent>();
+        for (auto i = 0u; i < group->size(); i++) {
+            REQUIRE(owned[i].entityID == other[i].entityID);
+            REQUIRE(owned[i].value == other[i].value);
+        }
+        for (auto i = group->size(); i < owned.size(); i++) {
+            REQUIRE_FALSE(group->contains(owned[i].entityID));
+        }
+
+        auto count = 0u;
+        for (auto [entity, first, second] : *group) {
+            REQUIRE(first.entityID == entity);
+            REQUIRE(second.entityID == entity);
+            count++;
+        }
+        REQUIRE(count == group->size());
+    };
+
+    REQUIRE(group->size() == 5);
+    requirePacked();
+
+    components.addComponent<OtherOwnedComponent>(all[3])->value = 3;
+    REQUIRE(group->size() == 6);
+    requirePacked();
+
+    components.deleteComponent<OwnedComponent>(all[0]);
+    REQUIRE(group->size() == 5);
+    requirePacked();
+
+    entities.deleteEntity(all[4]);
+    REQUIRE(group->size() == 4);
+    requirePacked();
+
+    // moved components are still found by their entities
+    REQUIRE(components.getComponent<OwnedComponent>(all[3])->value == 3);
+    REQUIRE(components.getComponent<OwnedComponent>(all[9])->value == 9);
+
+    // owned containers can also be in non-owning groups
+    auto& plain = components.group<OtherOwnedComponent, OwnedComponent>();
+    REQUIRE(plain.size() == group->size());
+}
@@ -0,0 +1,79 @@
+#include <catch.hpp>
+#include <atomic>
+#include <stdexcept>
+#include "ecs/ecs.h"
+using namespace EECS;
+
+TEST_CASE("ThreadPool executes every job exactly once") {
+    ThreadPool pool(4);
+    REQUIRE(pool.size() == 4);
+
+    std::vector<std::atomic<int>> executions(1000);
+    std::vector<int> threadsUsed(pool.size());
+
+    // jobs of varying length, so that threads have to steal from each other
+    pool.run(executions.size(), [&](size_t job, size_t thread) {
+        auto spin = std::atomic<int>{0};
+        for (auto i = 0u; i < (job % 10) * 100; i++) {
+            spin++;
+        }
+        executions[job]++;
+        threadsUsed[thread] = 1;
+    });
+
+    for (auto& executed : executions) {
+        REQUIRE(executed == 1);
+    }
+
+    // pool is reusable
+    pool.run(executions.size(), [&](size_t job, size_t) { executions[job]++; });
+    for (auto& executed : executions) {
+        REQUIRE(executed == 2);
+    }
+}
+
+TEST_CASE("ThreadPool runs nested batches serially") {
+    ThreadPool pool(4);
+
+    // Catch assertions aren't thread-safe, so results are checked after batch
+    std::atomic<int> executions{0};
+    std::atomic<bool> allSerial{true};
+    pool.run(8, [&](size_t, size_t) {
+        pool.run(8, [&](size_t, size_t thread) {
+            allSerial = allSerial && thread == 0;
+            executions++;
+        });
+    });
+
+    REQUIRE(executions == 64);
+    REQUIRE(allSerial);
+}
+
+TEST_CASE("ThreadPool rethrows exception from job") {
+    ThreadPool pool(2);
+
+    REQUIRE_THROWS_AS(pool.run(100,
+                               [](size_t job, size_t) {
+                                   if (job == 50) {
+                                       throw std::runtime_error("job failed");
+                                   }
+                               }),
+                      const std::runtime_error&);
+
+    // pool still works after that
+    std::atomic<int> executions{0};
+    pool.run(100, [&](size_t, size_t) { executions++; });
+    REQUIRE(executions == 100);
+}
+
+TEST_CASE("ThreadPool can be resized") {
+    ThreadPool pool(1);
+    REQUIRE(pool.size() == 1);
+
+    pool.resize(3);
+    REQUIRE(pool.size() == 3);
+
+    std::atomic<int> executions{0};
+    pool.run(10, [&](size_t, size_t) { executions++; });
+    REQUIRE(executions == 10);
+}
@@ -0,0 +1,75 @@
+#include <catch.hpp>
+#include <algorithm>
+#include <sstream>
+#include <string>
+#include "ecs/ecs.h"
+using namespace EECS;
+
+namespace {
+size_t countOf(const std::string& text, const std::string& pattern) {
+    auto count = size_t{0};
+    for (auto position = text.find(pattern); position != std::string::npos; position = text.find(pattern, position + 1)) {
+        count++;
+    }
+    return count;
+}
+}
+
+TEST_CASE("Profiler records zones of every thread", "[Profiler]") {
+    auto& profiler = Profiler::get();
+    profiler.setCapacity(64);
+    profiler.clear();
+
+    {
+        ProfileZone outer("outer");
+        ProfileZone inner("inner \"quoted\"");
+    }
+
+    ThreadPool pool(4);
+    pool.run(40, [](size_t, size_t) { ProfileZone zone("job"); });
+
+    auto samples = profiler.samples();
+    REQUIRE(std::count_if(samples.begin(), samples.end(),
+                          [](const ProfileSample& sample) { return std::string(sample.name) == "job"; }) == 40);
+    for (const auto& sample : samples) {
+        REQUIRE(sample.start <= sample.end);
+    }
+
+    std::stringstream trace;
+    profiler.exportChromeTrace(trace);
+    auto json = trace.str();
+    REQUIRE(json.rfind("{\"traceEvents\":[", 0) == 0);
+    REQUIRE(countOf(json, "\"ph\":\"X\"") == 42);
+    REQUIRE(countOf(json, "\"name\":\"job\"") == 40);
+    REQUIRE(json.find("\"name\":\"inner \\\"quoted\\\"\"") != std::string::npos);
+
+    // zones are compiled out unless ECS_PROFILING is defined
+    profiler.clear();
+    {
+        ECS_PROFILE_ZONE("macro");
+    }
+#if defined(ECS_PROFILING)
+    REQUIRE(profiler.samples().size() == 1);
+#else
+    REQUIRE(profiler.samples().empty());
+#endif
+}
+
+TEST_CASE("Profiler keeps only latest samples of each thread", "[Profiler]") {
+    auto& profiler = Profiler::get();
+    profiler.setCapacity(4);
+    profiler.clear();
+
+    const char* names[] = {"0", "1", "2", "3", "4", "5"};
+    for (auto name : names) {
+        ProfileZone zone(name);
+    }
+
+    auto samples = profiler.samples();
+    REQUIRE(samples.size() == 4);
+    REQUIRE(std::string(samples.front().name) == "2");
+    REQUIRE(std::string(samples.back().name) == "5");
+
+    profiler.setCapacity(1 << 16);
+    profiler.clear();
+}
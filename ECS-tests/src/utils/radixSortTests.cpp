@@ -0,0 +1,38 @@
+#include <catch.hpp>
+#include <algorithm>
+#include <cstdint>
+#include <random>
+#include <utility>
+#include <vector>
+#include "ecs/ecs.h"
+using namespace EECS;
+
+TEST_CASE("Radix sort orders elements by key and keeps order of equal ones", "[RadixSort]") {
+    // second member is original position, to check stability
+    using Element = std::pair<uint64_t, size_t>;
+    std::vector<Element> elements, scratch;
+
+    std::mt19937 random(42);
+    for (auto i = 0u; i < 1000; i++) {
+        // keys differing in low and high bytes, with many duplicates
+        auto key = (uint64_t)(random() % 20) << 40 | (random() % 5);
+        elements.push_back({key, i});
+    }
+
+    auto expected = elements;
+    std::stable_sort(expected.begin(), expected.end(),
+                     [](const Element& first, const Element& second) { return first.first < second.first; });
+
+    radixSort(elements, scratch, [](const Element& element) { return element.first; });
+    REQUIRE(elements == expected);
+
+    // sorted again, and with all keys equal, order doesn't change
+    radixSort(elements, scratch, [](const Element& element) { return element.first; });
+    REQUIRE(elements == expected);
+    radixSort(elements, scratch, [](const Element&) { return 7u; });
+    REQUIRE(elements == expected);
+
+    std::vector<Element> empty;
+    radixSort(empty, scratch, [](const Element& element) { return element.first; });
+    REQUIRE(empty.empty());
+}
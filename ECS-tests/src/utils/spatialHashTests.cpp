@@ -0,0 +1,152 @@
+#include <catch.hpp>
+#include <algorithm>
+#include <utility>
+#include <vector>
+#include "ecs/ecs.h"
+using namespace EECS;
+
+namespace {
+std::vector<std::pair<EntityID, EntityID>> pairsOf(const SpatialHash& hash) {
+    std::vector<std::pair<EntityID, EntityID>> pairs;
+    hash.forEachPair([&](EntityID first, EntityID second) { pairs.push_back({first, second}); });
+    std::sort(pairs.begin(), pairs.end());
+    return pairs;
+}
+}
+
+TEST_CASE("SpatialHash reports only overlapping pairs", "[SpatialHash]") {
+    SpatialHash hash(1.f);
+
+    // wall spanning several cells, and two bodies touching it
+    hash.update(1, {0.f, 0.f, 10.f, 1.f}, true);
+    hash.update(2, {2.5f, 0.5f, 3.5f, 1.5f}, false);
+    hash.update(3, {3.f, 0.8f, 4.f, 1.8f}, false);
+    // far away from everything
+    hash.update(4, {50.f, 50.f, 51.f, 51.f}, false);
+    // static body overlapping the wall is never reported
+    hash.update(5, {5.f, 0.f, 6.f, 1.f}, true);
+
+    using Pairs = std::vector<std::pair<EntityID, EntityID>>;
+    auto expected = Pairs{{2, 1}, {2, 3}, {3, 1}};
+    REQUIRE(pairsOf(hash) == expected);
+
+    SECTION("Moving body leaves old cells") {
+        hash.update(3, {50.5f, 50.5f, 51.5f, 51.5f}, false);
+        expected = Pairs{{2, 1}, {3, 4}};
+        REQUIRE(pairsOf(hash) == expected);
+    }
+
+    SECTION("Touching boxes don't overlap") {
+        hash.update(2, {2.f, 1.f, 3.f, 2.f}, false);
+        hash.update(3, {3.f, 1.f, 4.f, 2.f}, false);
+        REQUIRE(pairsOf(hash).empty());
+    }
+
+    SECTION("Changing cell size keeps pairs") {
+        hash.setCellSize(4.f);
+        REQUIRE(pairsOf(hash) == expected);
+        hash.setCellSize(0.25f);
+        REQUIRE(pairsOf(hash) == expected);
+    }
+}
+
+TEST_CASE("SpatialHash removes bodies", "[SpatialHash]") {
+    SpatialHash hash(1.f);
+    hash.update(1, {0.f, 0.f, 1.f, 1.f}, true);
+    hash.update(2, {0.5f, 0.5f, 1.5f, 1.5f}, false);
+    hash.update(3, {-1.5f, -1.5f, 0.75f, 0.75f}, false);
+    REQUIRE(hash.size() == 3);
+    REQUIRE(pairsOf(hash).size() == 3);
+
+    REQUIRE(hash.remove(2));
+    REQUIRE_FALSE(hash.remove(2));
+    REQUIRE(hash.size() == 2);
+    using Pairs = std::vector<std::pair<EntityID, EntityID>>;
+    auto expected = Pairs{{3, 1}};
+    REQUIRE(pairsOf(hash) == expected);
+
+    // body not updated since previous frame is removed
+    hash.removeStale();
+    hash.update(3, {-1.5f, -1.5f, 0.75f, 0.75f}, false);
+    hash.removeStale();
+    REQUIRE(hash.size() == 1);
+    REQUIRE(pairsOf(hash).empty());
+
+    // entity which reuses index of deleted one replaces its body
+    auto recycled = makeEntityID(entityIndex(3), entityGeneration(3) + 1);
+    hash.update(recycled, {10.f, 10.f, 11.f, 11.f}, false);
+    REQUIRE(hash.size() == 1);
+    REQUIRE_FALSE(hash.remove(3));
+    REQUIRE(hash.remove(recycled));
+
+    hash.update(4, {0.f, 0.f, 1.f, 1.f}, true);
+    hash.update(5, {0.f, 0.f, 1.f, 1.f}, false);
+    hash.removeIf([](EntityID entity) { return entity == 4; });
+    REQUIRE(hash.size() == 1);
+    REQUIRE_FALSE(hash.remove(4));
+
+    hash.clear();
+    REQUIRE(hash.size() == 0);
+}
+
+TEST_CASE("SpatialHash tests crowded cells in batches", "[SpatialHash]") {
+    // many small static bodies in a single cell, so they're tested in several batches
+    SpatialHash hash(100.f);
+    for (auto i = 0u; i < 21; i++) {
+        hash.update(i + 1, {(float)i, 0.f, i + 0.9f, 1.f}, true);
+    }
+    hash.update(100, {2.5f, 0.5f, 10.5f, 1.5f}, false);
+
+    auto expected = std::vector<std::pair<EntityID, EntityID>>{};
+    for (EntityID i = 3; i <= 11; i++) {
+        expected.push_back({100, i});
+    }
+    REQUIRE(pairsOf(hash) == expected);
+
+    // static bodies can move too
+    hash.update(21, {5.f, 0.f, 6.f, 1.f}, true);
+    hash.update(3, {50.f, 0.f, 51.f, 1.f}, true);
+    expected.erase(expected.begin());
+    expected.push_back({100, 21});
+    REQUIRE(pairsOf(hash) == expected);
+}
+
+TEST_CASE("SpatialHash finds bodies inside of box", "[SpatialHash]") {
+    SpatialHash hash(1.f);
+    hash.update(1, {0.f, 0.f, 10.f, 1.f}, true);
+    hash.update(2, {2.5f, 0.5f, 3.5f, 1.5f}, false);
+    hash.update(3, {5.f, 5.f, 6.f, 6.f}, true);
+    hash.update(4, {-20.f, -20.f, -19.f, -19.f}, false);
+
+    auto bodiesIn = [&](SpatialHash::Box box) {
+        std::vector<EntityID> found;
+        hash.forEachInBox(box, [&](EntityID entity) { found.push_back(entity); });
+        std::sort(found.begin(), found.end());
+        return found;
+    };
+
+    // bodies spanning many cells of the box are reported once
+    REQUIRE((bodiesIn({2.f, 0.f, 6.f, 6.f}) == std::vector<EntityID>{1, 2, 3}));
+    REQUIRE((bodiesIn({4.f, 2.f, 5.5f, 5.5f}) == std::vector<EntityID>{3}));
+    REQUIRE(bodiesIn({20.f, 20.f, 21.f, 21.f}).empty());
+
+    // box covering more cells than there are bodies
+    REQUIRE((bodiesIn({-100.f, -100.f, 100.f, 100.f}) == std::vector<EntityID>{1, 2, 3, 4}));
+}
+
+TEST_CASE("SpatialHash drops cells left by bodies", "[SpatialHash]") {
+    SpatialHash hash(1.f);
+    hash.update(1, {0.f, 0.f, 10.f, 1.f}, true);
+    auto wallCells = hash.cellCount();
+
+    // body moving through many cells, like the bird in Flappy
+    for (auto i = 0; i < 1000; i++) {
+        hash.update(2, {(float)i, 5.f, i + 0.5f, 5.5f}, false);
+        REQUIRE(hash.cellCount() <= wallCells + 1);
+    }
+
+    hash.remove(2);
+    REQUIRE(hash.cellCount() == wallCells);
+    hash.remove(1);
+    REQUIRE(hash.cellCount() == 0);
+}
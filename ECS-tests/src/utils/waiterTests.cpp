@@ -0,0 +1,30 @@
+#include <catch.hpp>
+#include "ecs/ecs.h"
+using namespace EECS;
+
+TEST_CASE("Waiter returns at deadline with each strategy", "[Waiter]") {
+    for (auto strategy : {WaitStrategy::Sleep, WaitStrategy::Hybrid, WaitStrategy::BusyPoll}) {
+        Waiter waiter(strategy, std::chrono::microseconds(500));
+
+        for (auto i = 0; i < 3; i++) {
+            auto deadline = Waiter::Clock::now() + std::chrono::milliseconds(2);
+            waiter.waitUntil(deadline);
+            REQUIRE(Waiter::Clock::now() >= deadline);
+        }
+
+        REQUIRE(waiter.stats().waits == 3);
+        REQUIRE(waiter.stats().lastLatency >= std::chrono::nanoseconds(0));
+        REQUIRE(waiter.stats().maxLatency >= waiter.stats().meanLatency());
+
+        // deadline which has already passed isn't waited for, nor counted
+        waiter.waitUntil(Waiter::Clock::now() - std::chrono::milliseconds(1));
+        REQUIRE(waiter.stats().waits == 3);
+    }
+}
+
+TEST_CASE("Wait strategy is parsed from its name", "[Waiter]") {
+    REQUIRE(Waiter::parseStrategy("sleep") == WaitStrategy::Sleep);
+    REQUIRE(Waiter::parseStrategy("busy") == WaitStrategy::BusyPoll);
+    REQUIRE(Waiter::parseStrategy("hybrid") == WaitStrategy::Hybrid);
+    REQUIRE(Waiter::parseStrategy("unknown") == WaitStrategy::Hybrid);
+}
@@ -12,5 +12,9 @@
 #include "../src/utils/loggerFileOutput.h"
 #include "../src/utils/config.h"
 #include "../src/utils/formatString.h"
+#include "../src/utils/spatialHash.h"
 #include "../src/utils/stringUtils.h"
 #include "../src/utils/timer.h"
+#include "../src/utils/profiler.h"
+#include "../src/utils/radixSort.h"
+#include "../src/utils/waiter.h"
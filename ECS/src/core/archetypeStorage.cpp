@@ -0,0 +1,232 @@
+#include "archetypeStorage.h"
+#include <algorithm>
+
+using namespace EECS;
+
+namespace {
+size_t alignUp(size_t value, size_t alignment) { return (value + alignment - 1) / alignment * alignment; }
+}
+
+Archetype::Archetype(std::vector<size_t> types, const std::vector<ComponentTypeInfo>& typeInfos)
+    : types(std::move(types)) {
+    auto rowSize = sizeof(EntityID);
+    for (auto type : this->types) {
+        columnInfos.push_back(typeInfos[type]);
+        rowSize += typeInfos[type].size;
+    }
+
+    columnOffsets.resize(columnInfos.size());
+    capacity = std::max<size_t>(1, chunkSize / rowSize);
+
+    // shrink capacity until all columns, with their alignment padding, fit into the chunk. Components bigger than
+    // whole chunk get one row per chunk, in chunk as big as necessary.
+    while (true) {
+        auto offset = sizeof(EntityID) * capacity;
+        for (auto i = 0u; i < columnInfos.size(); i++) {
+            offset = alignUp(offset, columnInfos[i].alignment);
+            columnOffsets[i] = offset;
+            offset += columnInfos[i].size * capacity;
+        }
+
+        if (offset <= bytesPerChunk) {
+            break;
+        }
+
+        if (capacity > 1) {
+            capacity--;
+        } else {
+            bytesPerChunk = alignUp(offset, chunkAlignment);
+            break;
+        }
+    }
+}
+
+int Archetype::columnOf(size_t typeID) const {
+    auto it = std::lower_bound(types.begin(), types.end(), typeID);
+    return it != types.end() && *it == typeID ? int(it - types.begin()) : -1;
+}
+
+size_t Archetype::pushRow(EntityID entity) {
+    if (entityCount == chunks.size() * capacity) {
+        chunks.emplace_back((std::byte*)::operator new[](bytesPerChunk, std::align_val_t{chunkAlignment}));
+    }
+
+    auto row = entityCount++;
+    entities(row / capacity)[row % capacity] = entity;
+    return row;
+}
+
+bool ArchetypeStorage::remove(size_t typeID, EntityID entity) {
+    if (!get(typeID, entity)) {
+        return false;
+    }
+
+    moveEntity(entity, typeID, false);
+    return true;
+}
+
+void ArchetypeStorage::removeEntity(EntityID entity) {
+    auto archetypeIndex = archetypeIndexOf(entity);
+    if (archetypeIndex == SparseIndex::npos) {
+        return;
+    }
+
+    auto& archetype = archetypes[archetypeIndex];
+    auto row = rowOf.get(entity);
+    for (auto column = 0u; column < archetype.columnInfos.size(); column++) {
+        archetype.columnInfos[column].destroy(archetype.componentAt(row, column));
+        typeCounts[archetype.types[column]]--;
+    }
+
+    eraseRow(archetype, row);
+    archetypeOf.reset(entity);
+    rowOf.reset(entity);
+}
+
+void ArchetypeStorage::clear(size_t typeID) {
+    auto archetypesCount = archetypes.size();
+    for (auto i = 0u; i < archetypesCount; i++) {
+        if (archetypes[i].columnOf(typeID) < 0) {
+            continue;
+        }
+
+        // removing from the end doesn't need to relocate any other row
+        while (archetypes[i].size() > 0) {
+            moveEntity(archetypes[i].entityAt(archetypes[i].size() - 1), typeID, false);
+        }
+    }
+}
+
+void ArchetypeStorage::clear() {
+    for (auto& archetype : archetypes) {
+        for (auto row = 0u; row < archetype.size(); row++) {
+            for (auto column = 0u; column < archetype.columnInfos.size(); column++) {
+                archetype.columnInfos[column].destroy(archetype.componentAt(row, column));
+            }
+        }
+
+        // chunks are kept, so refilling the archetype won't allocate
+        archetype.entityCount = 0;
+    }
+
+    archetypeOf.clear();
+    rowOf.clear();
+    std::fill(typeCounts.begin(), typeCounts.end(), 0);
+}
+
+void* ArchetypeStorage::get(size_t typeID, EntityID entity) const {
+    auto archetypeIndex = archetypeIndexOf(entity);
+    if (archetypeIndex == SparseIndex::npos) {
+        return nullptr;
+    }
+
+    auto& archetype = archetypes[archetypeIndex];
+    auto column = archetype.columnOf(typeID);
+    return column < 0 ? nullptr : archetype.componentAt(rowOf.get(entity), column);
+}
+
+uint32_t ArchetypeStorage::findOrCreateArchetype(std::vector<size_t> types) {
+    auto it = archetypeBySignature.find(types);
+    if (it != archetypeBySignature.end()) {
+        return it->second;
+    }
+
+    auto index = (uint32_t)archetypes.size();
+    archetypeBySignature.emplace(types, index);
+    archetypes.emplace_back(std::move(types), typeInfos);
+    return index;
+}
+
+std::pair<uint32_t, size_t> ArchetypeStorage::moveEntity(EntityID entity, size_t typeID, bool addType) {
+    auto source = archetypeIndexOf(entity);
+
+    // find destination archetype, through cached transition if possible
+    auto destination = SparseIndex::npos;
+    if (source != SparseIndex::npos) {
+        auto& transitions = addType ? archetypes[source].addTransitions : archetypes[source].removeTransitions;
+        if (typeID < transitions.size()) {
+            destination = transitions[typeID];
+        }
+    }
+
+    auto sourceTypes = source != SparseIndex::npos ? archetypes[source].types : std::vector<size_t>{};
+    if (destination == SparseIndex::npos) {
+        auto destinationTypes = sourceTypes;
+        if (addType) {
+            destinationTypes.insert(std::lower_bound(destinationTypes.begin(), destinationTypes.end(), typeID), typeID);
+        } else {
+            destinationTypes.erase(std::lower_bound(destinationTypes.begin(), destinationTypes.end(), typeID));
+        }
+
+        if (!destinationTypes.empty()) {
+            destination = findOrCreateArchetype(std::move(destinationTypes));
+
+            if (source != SparseIndex::npos) {
+                auto& transitions =
+                    addType ? archetypes[source].addTransitions : archetypes[source].removeTransitions;
+                if (transitions.size() <= typeID) {
+                    transitions.resize(typeID + 1, SparseIndex::npos);
+                }
+                transitions[typeID] = destination;
+            }
+        }
+    }
+
+    // archetypes won't be created anymore, so references are stable from now on
+    auto destinationRow = size_t{0};
+    if (destination != SparseIndex::npos) {
+        destinationRow = archetypes[destination].pushRow(entity);
+    }
+
+    if (source != SparseIndex::npos) {
+        auto& sourceArchetype = archetypes[source];
+        auto sourceRow = rowOf.get(entity);
+
+        for (auto column = 0u; column < sourceArchetype.columnInfos.size(); column++) {
+            auto component = sourceArchetype.componentAt(sourceRow, column);
+            auto& info = sourceArchetype.columnInfos[column];
+
+            if (destination != SparseIndex::npos) {
+                auto destinationColumn = archetypes[destination].columnOf(sourceArchetype.types[column]);
+                if (destinationColumn >= 0) {
+                    info.moveConstruct(archetypes[destination].componentAt(destinationRow, destinationColumn),
+                                       component);
+                }
+            }
+
+            info.destroy(component);
+        }
+
+        eraseRow(sourceArchetype, sourceRow);
+    }
+
+    typeCounts[typeID] += addType ? 1 : -1;
+
+    if (destination != SparseIndex::npos) {
+        archetypeOf.set(entity, destination);
+        rowOf.set(entity, (uint32_t)destinationRow);
+    } else {
+        archetypeOf.reset(entity);
+        rowOf.reset(entity);
+    }
+
+    return {destination, destinationRow};
+}
+
+void ArchetypeStorage::eraseRow(Archetype& archetype, size_t row) {
+    auto lastRow = archetype.size() - 1;
+
+    if (row != lastRow) {
+        for (auto column = 0u; column < archetype.columnInfos.size(); column++) {
+            auto last = archetype.componentAt(lastRow, column);
+            archetype.columnInfos[column].moveConstruct(archetype.componentAt(row, column), last);
+            archetype.columnInfos[column].destroy(last);
+        }
+
+        auto movedEntity = archetype.entityAt(lastRow);
+        archetype.entities(row / archetype.capacity)[row % archetype.capacity] = movedEntity;
+        rowOf.set(movedEntity, (uint32_t)row);
+    }
+
+    archetype.entityCount--;
+}
@@ -0,0 +1,191 @@
+#pragma once
+#include <cstddef>
+#include <map>
+#include <memory>
+#include <new>
+#include <span>
+#include <vector>
+#include "entityID.h"
+#include "sparseIndex.h"
+#include "componentContainerID.h"
+
+namespace EECS {
+
+// Operations needed to move components of some type around memory without knowing the type.
+struct ComponentTypeInfo {
+    size_t size = 0;
+    size_t alignment = 0;
+    void (*moveConstruct)(void* destination, void* source) = nullptr;
+    void (*destroy)(void* component) = nullptr;
+};
+
+/** \brief set of entities which have exactly the same set of Archetype-stored component types
+*
+* Components are kept in chunks of fixed size. Each chunk is structure of arrays: array of EntityIDs, followed by
+* one array per component type. Rows are always packed - every chunk except the last one is full.
+*/
+class Archetype {
+public:
+    static constexpr size_t chunkSize = 16 * 1024;
+    static constexpr size_t chunkAlignment = 64;
+
+    Archetype(std::vector<size_t> types, const std::vector<ComponentTypeInfo>& typeInfos);
+
+    // sorted ComponentContainerIDs of types stored in this archetype
+    const std::vector<size_t>& getTypes() const { return types; }
+
+    // returns index of column which stores given type, or -1 if archetype doesn't have it.
+    int columnOf(size_t typeID) const;
+
+    size_t size() const { return entityCount; }
+    size_t chunkCount() const { return (entityCount + capacity - 1) / capacity; }
+    size_t chunkCapacity() const { return capacity; }
+
+    // amount of entities stored in given chunk
+    size_t chunkSizeOf(size_t chunk) const {
+        return chunk + 1 < chunkCount() ? capacity : entityCount - chunk * capacity;
+    }
+
+    EntityID* entities(size_t chunk) const { return (EntityID*)chunks[chunk].get(); }
+    void* column(size_t chunk, int column) const { return chunks[chunk].get() + columnOffsets[column]; }
+
+    EntityID entityAt(size_t row) const { return entities(row / capacity)[row % capacity]; }
+    void* componentAt(size_t row, int column) const {
+        return (std::byte*)this->column(row / capacity, column) + (row % capacity) * columnInfos[column].size;
+    }
+
+private:
+    struct ChunkDeleter {
+        void operator()(std::byte* memory) const { ::operator delete[](memory, std::align_val_t{chunkAlignment}); }
+    };
+
+    std::vector<size_t> types;
+    std::vector<ComponentTypeInfo> columnInfos;
+    std::vector<size_t> columnOffsets;
+    size_t capacity = 0;
+    size_t bytesPerChunk = chunkSize;
+
+    std::vector<std::unique_ptr<std::byte[], ChunkDeleter>> chunks;
+    size_t entityCount = 0;
+
+    // cached transitions to other archetypes, indexed by ComponentContainerID. SparseIndex::npos if not computed yet.
+    std::vector<uint32_t> addTransitions;
+    std::vector<uint32_t> removeTransitions;
+
+    // reserves memory for new row at the end and returns its index. Components in it are not constructed.
+    size_t pushRow(EntityID entity);
+
+    friend class ArchetypeStorage;
+};
+
+/** \brief storage engine which groups entities by their exact set of Archetype-stored component types
+*
+* It's used by ComponentContainers of types which declared ComponentStorage::Archetype. Adding or deleting such
+* component moves all Archetype-stored components of the entity to another Archetype, so pointers to them are
+* invalidated. In exchange, queries over several such types can stream through chunks of matching archetypes
+* without any per-entity lookups.
+*/
+class ArchetypeStorage {
+public:
+    ArchetypeStorage() = default;
+    ArchetypeStorage(const ArchetypeStorage&) = delete;
+    ArchetypeStorage& operator=(const ArchetypeStorage&) = delete;
+    ~ArchetypeStorage() { clear(); }
+
+    // adds new component, replaces existing component if already exists. Returns pointer to it.
+    template <class T, class... Args>
+    T* add(EntityID entity, Args&&... args) {
+        static_assert(alignof(T) <= Archetype::chunkAlignment, "Component alignment is too big for Archetype storage");
+        auto typeID = ComponentContainerID::get<T>();
+        registerType<T>(typeID);
+
+        if (auto existing = (T*)get(typeID, entity)) {
+            *existing = T(std::forward<Args>(args)...);
+            existing->entityID = entity;
+            return existing;
+        }
+
+        auto [archetype, row] = moveEntity(entity, typeID, true);
+        auto component = new (archetypes[archetype].componentAt(row, archetypes[archetype].columnOf(typeID)))
+            T(std::forward<Args>(args)...);
+        component->entityID = entity;
+        return component;
+    }
+
+    // deletes component of given type. Returns false if entity didn't have it.
+    bool remove(size_t typeID, EntityID entity);
+
+    // deletes all Archetype-stored components of the entity.
+    void removeEntity(EntityID entity);
+
+    // deletes all components of given type.
+    void clear(size_t typeID);
+
+    // deletes all components.
+    void clear();
+
+    // returns pointer to component of given type owned by entity, or nullptr if it doesn't exist. O(lg types).
+    void* get(size_t typeID, EntityID entity) const;
+
+    // number of entities which have component of given type
+    size_t count(size_t typeID) const { return typeID < typeCounts.size() ? typeCounts[typeID] : 0; }
+
+    // ComponentContainerIDs of all Archetype-stored components of given entity, sorted.
+    std::span<const size_t> typesOf(EntityID entity) const {
+        auto archetype = archetypeIndexOf(entity);
+        if (archetype == SparseIndex::npos) {
+            return {};
+        }
+        return archetypes[archetype].getTypes();
+    }
+
+    // all archetypes created so far. Some of them may be empty.
+    const std::vector<Archetype>& getArchetypes() const { return archetypes; }
+
+private:
+    std::vector<Archetype> archetypes;
+    std::map<std::vector<size_t>, uint32_t> archetypeBySignature;
+    std::vector<ComponentTypeInfo> typeInfos;
+    std::vector<size_t> typeCounts;
+
+    // which archetype and which row of it holds components of given entity
+    SparseIndex archetypeOf;
+    SparseIndex rowOf;
+
+    // archetype which holds components of given entity, or npos if there is none. Stale IDs, which share index with
+    // some living entity, also give npos.
+    uint32_t archetypeIndexOf(EntityID entity) const {
+        auto archetypeIndex = archetypeOf.get(entity);
+        if (archetypeIndex == SparseIndex::npos || archetypes[archetypeIndex].entityAt(rowOf.get(entity)) != entity) {
+            return SparseIndex::npos;
+        }
+
+        return archetypeIndex;
+    }
+
+    template <class T>
+    void registerType(size_t typeID) {
+        if (typeInfos.size() <= typeID) {
+            typeInfos.resize(typeID + 1);
+            typeCounts.resize(typeID + 1);
+        }
+
+        if (typeInfos[typeID].size == 0) {
+            typeInfos[typeID] = {sizeof(T), alignof(T),
+                                 [](void* destination, void* source) { new (destination) T(std::move(*(T*)source)); },
+                                 [](void* component) { ((T*)component)->~T(); }};
+        }
+    }
+
+    // returns index of archetype with given signature, creates it if necessary.
+    uint32_t findOrCreateArchetype(std::vector<size_t> types);
+
+    // moves entity to archetype which additionally has(or doesn't have) given type, and returns its new location.
+    // If type is added, its component isn't constructed. If type is removed, its component is destroyed.
+    std::pair<uint32_t, size_t> moveEntity(EntityID entity, size_t typeID, bool addType);
+
+    // removes given row from archetype, by moving last row into its place. Components of the row must be already
+    // destroyed.
+    void eraseRow(Archetype& archetype, size_t row);
+};
+}
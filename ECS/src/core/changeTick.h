@@ -0,0 +1,8 @@
+#pragma once
+#include <cstdint>
+
+namespace EECS {
+// Moment in which component was added or changed, see Changed and Added filters. ComponentManager advances it after
+// every stage of tasks, so values only grow - 0 means "before anything happened".
+using Tick = uint32_t;
+}
@@ -0,0 +1,65 @@
+#include "commandBuffer.h"
+#include <cassert>
+#include "entity.h"
+#include "threadPool.h"
+
+using namespace EECS;
+
+CommandBuffer::CommandBuffer(EntityManager& entities, ComponentManager& components) :
+    entities(entities), components(components), buffers(1) {}
+
+void CommandBuffer::setThreadCount(size_t threadCount) {
+    if (threadCount > buffers.size()) {
+        buffers.resize(threadCount);
+    }
+}
+
+EntityID CommandBuffer::addEntity(EntityID prototype) {
+    auto entity = entities.reserveEntity();
+    local().push_back({Command::Type::AddEntity, entity, prototype, nullptr});
+    return entity;
+}
+
+void CommandBuffer::deleteEntity(EntityID entity) { local().push_back({Command::Type::DeleteEntity, entity, 0, nullptr}); }
+
+void CommandBuffer::playback() {
+    for (auto& buffer : buffers) {
+        for (auto& command : buffer.commands) {
+            switch (command.type) {
+                case Command::Type::AddEntity:
+                    entities.createReservedEntity(command.entity, command.prototype);
+                    break;
+                case Command::Type::DeleteEntity:
+                    deletedEntities.push_back(command.entity);
+                    break;
+                case Command::Type::ChangeComponent:
+                    command.change(components);
+                    break;
+            }
+        }
+        buffer.commands.clear();
+    }
+
+    entities.destroyBatch(deletedEntities);
+    deletedEntities.clear();
+}
+
+bool CommandBuffer::empty() const {
+    for (const auto& buffer : buffers) {
+        if (!buffer.commands.empty()) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+std::vector<CommandBuffer::Command>& CommandBuffer::local() {
+    auto thread = ThreadPool::currentThread();
+    assert(thread < buffers.size() && "CommandBuffer used from thread which it isn't prepared for, see setThreadCount");
+    return buffers[thread].commands;
+}
+
+void CommandBuffer::record(EntityID entity, std::function<void(ComponentManager&)> change) {
+    local().push_back({Command::Type::ChangeComponent, entity, 0, std::move(change)});
+}
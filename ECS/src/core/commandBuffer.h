@@ -0,0 +1,83 @@
+#pragma once
+#include <functional>
+#include <vector>
+#include "componentManager.h"
+#include "entityID.h"
+
+namespace EECS {
+class EntityManager;
+
+/** \brief records structural changes - creation and deletion of entities and components - to apply them later at once
+*
+* Adding or deleting components can move other components of the same type, which invalidates pointers obtained
+* earlier, including these held by views. Tasks which iterate over components or run in parallel can record such
+* changes here instead. ECS plays them back after all tasks and events of the tick are processed, so within a tick
+* pointers to components stay valid.
+*
+* Commands can be recorded from threads of ECS's ThreadPool and from the main thread at once, as each thread records to
+* its own buffer. Commands of one thread are applied in order in which they were recorded, order between threads is
+* unspecified. Entities are deleted after all other commands, at once.
+*
+* auto bullet = ecs.commands.addEntity();
+* ecs.commands.addComponent<PositionComponent>(bullet, x, y);
+* ecs.commands.deleteEntity(target);
+*/
+class CommandBuffer {
+public:
+    CommandBuffer(EntityManager& entities, ComponentManager& components);
+
+    // has to be at least the amount of threads which record commands. Must not be called while commands are recorded.
+    void setThreadCount(size_t threadCount);
+
+    // returns ID of entity which will be created at playback, with copies of all components of prototype if it isn't
+    // 0. ID can be used in other commands right away.
+    EntityID addEntity(EntityID prototype = 0);
+
+    void deleteEntity(EntityID entity);
+
+    // component is constructed right away, and moved to the entity at playback.
+    template <class T, class... Args>
+    void addComponent(EntityID entity, Args&&... args) {
+        record(entity, [entity, component = T(std::forward<Args>(args)...)](ComponentManager& components) mutable {
+            components.addComponent<T>(entity, std::move(component));
+        });
+    }
+
+    template <class T>
+    void deleteComponent(EntityID entity) {
+        record(entity, [entity](ComponentManager& components) { components.deleteComponent<T>(entity); });
+    }
+
+    // applies all recorded commands and clears buffers. Must not be called while commands are recorded.
+    void playback();
+
+    bool empty() const;
+
+private:
+    struct Command {
+        enum class Type { AddEntity, DeleteEntity, ChangeComponent };
+
+        Type type;
+        EntityID entity;
+        EntityID prototype;
+        std::function<void(ComponentManager&)> change;
+    };
+
+    // aligned, so that threads don't write to the same cache line
+    struct alignas(64) ThreadBuffer {
+        std::vector<Command> commands;
+    };
+
+    EntityManager& entities;
+    ComponentManager& components;
+    std::vector<ThreadBuffer> buffers;
+
+    // reused between playbacks
+    std::vector<EntityID> deletedEntities;
+
+    // buffer of the calling thread
+    std::vector<Command>& local();
+
+    void record(EntityID entity, std::function<void(ComponentManager&)> change);
+};
+}
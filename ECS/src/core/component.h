@@ -1,49 +1,73 @@
 #pragma once
+#include "changeTick.h"
 #include "componentContainerID.h"
 #include "entityID.h"
 #include "globalDefs.h"
+#include <cassert>
+#include <type_traits>
 #include <unordered_map>
 
 namespace EECS {
 
-// todo: add checking for cyclical dependencies in ComponentManager's, add assert that there are none in it's
-// constructor. Then add Unit tests for whole Dependency System. Also, double-check if it doesn't add too much overhead.
-// Also, remember to finish that stuff written on that Vim page.
+// true if component type dependent requires type dependency, directly or not. Registered dependencies never form a
+// cycle, so it always ends.
+inline bool componentDependsOn(size_t dependent, size_t dependency) {
+    if (dependent == dependency) {
+        return true;
+    }
 
-template <typename What, typename... On>
-class Depends {
-    Depends() {
-        auto dependentID = ComponentContainerID::get<What>();
+    if (dependent >= componentDependencies().size()) {
+        return false;
+    }
 
-        if (componentDependencies().size() <= dependentID) {
-            componentDependencies().resize(dependentID + 1);
+    for (auto direct : componentDependencies()[dependent]) {
+        if (componentDependsOn(direct, dependency)) {
+            return true;
         }
+    }
+    return false;
+}
 
-        fillWithIDs(componentDependencies()[dependentID]);
+// registers that component type dependent requires type dependency, see Depends. Returns false, without registering
+// anything, if that would create a cycle of dependencies.
+inline bool addComponentDependency(size_t dependent, size_t dependency) {
+    if (componentDependsOn(dependency, dependent)) {
+        return false;
     }
 
-    template <typename H, typename... T>
-    void fillWithIDs(std::vector<size_t>& container) {
-        container.emplace_back(ComponentContainerID::get<H>());
-        fillWithIDs<T...>(container);
+    if (componentDependencies().size() <= dependent) {
+        componentDependencies().resize(dependent + 1);
     }
+    componentDependencies()[dependent].push_back(dependency);
+    return true;
+}
 
-    void fillWithIDs(std::vector<size_t>&) {}
+/** \brief declares that component What requires components On...
+*
+* Adding What to an entity also adds missing On... components, and deleting any of On... deletes What(unless whole
+* entity is deleted). Dependencies are declared by global objects, before any ComponentManager is created:
+*
+* Depends<SpriteComponent, PositionComponent, SizeComponent> spriteDependencies;
+*
+* ComponentManager implements them with observers, see ComponentManager::observe. Cyclic dependencies would make adding
+* or deleting any of these components recurse forever, so they are rejected here.
+*/
+template <typename What, typename... On>
+class Depends {
+    static_assert(!(std::is_same_v<What, On> || ...), "Component can't depend on itself!");
 
-    // ensure that Component doesn't depend on itself
-    template <typename S, typename H, typename... T>
-    constexpr bool dependsOnSelf() {
-        static_assert(!std::is_same<S, H>(), "Component can't depend on itself!");
-        dependsOnSelf<S, T...>();
-        return false;
+public:
+    Depends() {
+        auto dependentID = ComponentContainerID::get<What>();
+        (registerDependency(dependentID, ComponentContainerID::get<On>()), ...);
     }
 
-    template <typename S>
-    constexpr bool dependsOnSelf() {
-        return false;
+private:
+    static void registerDependency(size_t dependent, size_t dependency) {
+        auto registered = addComponentDependency(dependent, dependency);
+        assert(registered && "Cyclic component dependency");
+        (void)registered;
     }
-
-    static_assert(!dependsOnSelf<What, On...>());
 };
 
 // Used for registering component type in the system.
@@ -81,10 +105,23 @@ public:
 *   }
 * };
 *
+* By default components are kept sorted by EntityID. Types which are frequently added and deleted can opt into
+* SparseSet storage instead, see ComponentStorage:
+*
+* struct ParticleComponent : Component<ParticleComponent> {
+*   static constexpr ComponentStorage storage = ComponentStorage::SparseSet;
+*   float lifetime = 0.f;
+* };
+*
+* Each component also remembers when it was added and when it was last accessed for modification, so queries can
+* visit only components which changed since given moment, see Changed and Added.
+*
 */
 template <typename Derived>
 struct Component {
     EntityID entityID;
+    Tick addedTick = 0;
+    Tick changedTick = 0;
 
 private:
     Component() { (void)componentRegistrator; }
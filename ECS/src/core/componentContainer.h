@@ -1,11 +1,60 @@
 #pragma once
+#include "changeTick.h"
 #include "entityID.h"
+#include "sparseIndex.h"
+#include "archetypeStorage.h"
+#include "componentContainerID.h"
 #include <algorithm>
+#include <array>
+#include <functional>
 #include <memory>
+#include <span>
 #include <vector>
 
 namespace EECS {
 
+// Layout in which ComponentContainer keeps components of given type.
+//  Sorted - components sorted by EntityID. Lookup in O(lg n), addition and deletion in O(n). Iteration order follows
+//           EntityIDs. It's the default.
+//  SparseSet - components packed in arbitrary order, with paged sparse index from EntityID to their position. Lookup,
+//           addition and deletion in O(1); deletion moves last component into the hole. Good for types which are
+//           often created and destroyed.
+//  Archetype - components live in ArchetypeStorage of the ComponentManager, grouped with other Archetype-stored
+//           components of the same entity. Lookup in O(1), addition and deletion move all these components of the
+//           entity. Queries over several Archetype-stored types don't need any lookups. Components aren't contiguous
+//           per type, so getAllComponents isn't available, and container works only as a part of ComponentManager.
+// Component chooses it by declaring static member, for ex.:
+//  static constexpr ComponentStorage storage = ComponentStorage::SparseSet;
+enum class ComponentStorage { Sorted, SparseSet, Archetype };
+
+template <class T>
+constexpr ComponentStorage storageOf() {
+    if constexpr (requires { T::storage; }) {
+        return T::storage;
+    } else {
+        return ComponentStorage::Sorted;
+    }
+}
+
+// kinds of changes of components which observers are notified about, see ComponentManager::observe.
+enum class ComponentChange { Added, Replaced, Removed };
+
+// Persistent query which keeps track of entities which have some set of components, see group.h. Containers of these
+// components notify it about every change.
+class GroupBase {
+public:
+    virtual ~GroupBase() {}
+
+    // called after entity got one of the components
+    virtual void componentAdded(EntityID entity) = 0;
+
+    // called before entity loses one of the components, or is deleted. May be called for entities which aren't members.
+    virtual void componentRemoved(EntityID entity) = 0;
+
+    // called after all components of one of the types were deleted
+    virtual void cleared() = 0;
+};
+
 // Base of all component containers, for operations which need to be done without knowing exact type of container.
 class ComponentContainerBase {
 public:
@@ -18,23 +67,119 @@ public:
     virtual bool genericAddComponent(EntityID entity) = 0;
     virtual bool genericDeleteComponent(EntityID entity) = 0;
     virtual bool genericHasComponent(EntityID entity) = 0;
+
+    // batch versions of cloneComponent and genericDeleteComponent, which update container once for all entities.
+    // Entities have to be sorted and unique, and recipients can't have the component yet. Return amount of components
+    // cloned or deleted.
+    virtual size_t cloneComponents(EntityID sourceEntity, std::span<const EntityID> recipientEntities) = 0;
+    virtual size_t genericDeleteComponents(std::span<const EntityID> entities) = 0;
+
+    // used by ComponentManager to provide storage for Archetype-stored types.
+    virtual void setArchetypeStorage(ArchetypeStorage&) {}
+
+    // groups which include this type of component
+    std::vector<GroupBase*> groups;
+
+    // group which keeps order of components in this container, if any
+    GroupBase* owner = nullptr;
+
+    // tick of ComponentManager which owns this container, stamped on added and changed components
+    const Tick* tick = nullptr;
+
+    Tick currentTick() const { return tick ? *tick : 0; }
+
+    // registers function called with EntityID whenever given change happens to component of this type. Returns ID
+    // which unobserve() takes. See ComponentManager::observe.
+    size_t observe(ComponentChange change, std::function<void(EntityID)> function) {
+        observers[(size_t)change].push_back({++lastObserverID, std::move(function)});
+        return lastObserverID;
+    }
+
+    bool unobserve(size_t observerID) {
+        for (auto& list : observers) {
+            auto found = std::find_if(list.begin(), list.end(),
+                                      [observerID](const Observer& observer) { return observer.id == observerID; });
+            if (found != list.end()) {
+                list.erase(found);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // true if there is anything to notify about changes
+    bool observed() const {
+        return !groups.empty() || !observers[0].empty() || !observers[1].empty() || !observers[2].empty();
+    }
+
+    void notifyAdded(EntityID entity) {
+        for (auto group : groups) {
+            group->componentAdded(entity);
+        }
+        notify(ComponentChange::Added, entity);
+    }
+
+    // called before component is deleted, so observers can still read it
+    void notifyRemoved(EntityID entity) {
+        for (auto group : groups) {
+            group->componentRemoved(entity);
+        }
+        notify(ComponentChange::Removed, entity);
+    }
+
+protected:
+    void notifyReplaced(EntityID entity) { notify(ComponentChange::Replaced, entity); }
+
+    void notifyCleared() {
+        for (auto group : groups) {
+            group->cleared();
+        }
+    }
+
+private:
+    struct Observer {
+        size_t id;
+        std::function<void(EntityID)> function;
+    };
+
+    // indexed by ComponentChange
+    std::array<std::vector<Observer>, 3> observers;
+    size_t lastObserverID = 0;
+
+    void notify(ComponentChange change, EntityID entity) {
+        // by index, as observers can register other observers
+        const auto& list = observers[(size_t)change];
+        for (auto i = 0u; i < list.size(); i++) {
+            list[i].function(entity);
+        }
+    }
 };
 
 // Template class used for storing components of particular type.
 template <class T>
 class ComponentContainer : public ComponentContainerBase {
 public:
-    // returns pointer to a component owned by given entity, in O(lg n). nullptr if component doesn't exist.
+    // returns pointer to a component owned by given entity, in O(lg n), or O(1) for SparseSet storage. nullptr if
+    // component doesn't exist.
     T* getComponent(EntityID entityID) {
-        auto componentIt =
-            std::lower_bound(components.begin(), components.end(), entityID,
-                             [](const T& component, EntityID entityID) { return component.entityID < entityID; });
+        if constexpr (archetype) {
+            return archetypes ? (T*)archetypes->get(ComponentContainerID::get<T>(), entityID) : nullptr;
+        } else if constexpr (sparse) {
+            auto position = index.get(entityID);
+            if (position == SparseIndex::npos || components[position].entityID != entityID) {
+                return nullptr;
+            }
 
-        if (componentIt == components.end() || componentIt->entityID != entityID) {
-            return nullptr;
-        }
+            return &components[position];
+        } else {
+            auto componentIt = lowerBound(entityID);
+
+            if (componentIt == components.end() || componentIt->entityID != entityID) {
+                return nullptr;
+            }
 
-        return &*componentIt;
+            return &*componentIt;
+        }
     }
 
     bool genericHasComponent(EntityID entity) override{
@@ -45,30 +190,35 @@ public:
     // the vector in any way, otherwise class invariants could be invalidated. It's not const vector because then
     // modifying components itself would be impossible, which would render this method useless. If user wants to
     // batch process every/most of components, it's much faster than getting them one by one with getComponent. If user
-    // don't know exact entity id, then it's only viable method to do so.
-    std::vector<T>& getAllComponents() { return components; }
+    // don't know exact entity id, then it's only viable method to do so. Components are ordered by EntityID only in
+    // Sorted storage.
+    std::vector<T>& getAllComponents() {
+        static_assert(!archetype, "Archetype-stored components aren't contiguous, use ComponentManager::intersection");
+        return components;
+    }
 
     // adds new component, replaces existing component if already exists. Arguments after EntityID will be passed
     // directly to component's constructor. Returns pointer to created component.
     template <typename... Args>
     T* addComponent(EntityID entityID, Args&&... args) {
-        if (entityID == 0) {
-            return nullptr;
+        auto replaced = observed() && getComponent(entityID);
+        auto component = insert(entityID, std::forward<Args>(args)...);
+        if (component) {
+            component->addedTick = component->changedTick = currentTick();
         }
 
-        auto place =
-            std::lower_bound(components.begin(), components.end(), entityID,
-                             [](const T& component, EntityID entityID) { return component.entityID < entityID; });
+        if (component && observed()) {
+            if (replaced) {
+                notifyReplaced(entityID);
+            } else {
+                notifyAdded(entityID);
+            }
 
-        auto componentAlreadyExists = place != components.end() && place->entityID == entityID;
-        if (componentAlreadyExists) {
-            *place = T(std::forward<Args>(args)...);
-        } else {
-            place = components.insert(place, T(std::forward<Args>(args)...));
+            // owning group or observers could've moved the component
+            component = getComponent(entityID);
         }
 
-        place->entityID = entityID;
-        return &*place;
+        return component;
     }
 
     //used internally for dependency system
@@ -80,46 +230,219 @@ public:
         if (!sourceComponent)
             return false;
 
-        auto targetComponent = addComponent(recipientEntity);
-        if (!targetComponent)
-            return false;
-       
-        auto comps = getAllComponents();
-        if (!(!comps.empty() && &comps.front() <= sourceComponent && sourceComponent <= &comps.back() && sourceComponent->entityID == sourceEntity))
-            sourceComponent = getComponent(sourceEntity);
+        // copy first, so that observers get cloned values, and as adding component can relocate the source
+        T copy = *sourceComponent;
+        return addComponent(recipientEntity, std::move(copy));
+    }
 
-        *targetComponent = *sourceComponent;
-        targetComponent->entityID = recipientEntity;
+    // copies component of one entity to all recipients, see ComponentContainerBase. Linear in size of container.
+    size_t cloneComponents(EntityID sourceEntity, std::span<const EntityID> recipientEntities) override {
+        auto sourceComponent = getComponent(sourceEntity);
+        if (!sourceComponent)
+            return 0;
 
-        return true;
+        // copy first, as adding components can relocate the source
+        T copy = *sourceComponent;
+        copy.addedTick = copy.changedTick = currentTick();
+        if constexpr (archetype) {
+            auto cloned = size_t{0};
+            for (auto recipient : recipientEntities) {
+                cloned += addComponent(recipient, copy) ? 1 : 0;
+            }
+            return cloned;
+        } else {
+            auto oldSize = components.size();
+            components.reserve(oldSize + recipientEntities.size());
+            for (auto recipient : recipientEntities) {
+                components.push_back(copy);
+                components.back().entityID = recipient;
+                if constexpr (sparse) {
+                    index.set(recipient, (uint32_t)components.size() - 1);
+                }
+            }
+
+            // new components are already sorted, so single merge keeps the whole container sorted
+            if constexpr (!sparse) {
+                std::inplace_merge(components.begin(), components.begin() + oldSize, components.end(),
+                                   [](const T& a, const T& b) { return a.entityID < b.entityID; });
+            }
+
+            for (auto recipient : recipientEntities) {
+                notifyAdded(recipient);
+            }
+            return recipientEntities.size();
+        }
     }
 
     // Deletes component of a given Entity. Returns true if deleted, false if it doesn't exist in the first place.
     bool deleteComponent(EntityID entityID) {
-        auto componentIt =
-            std::lower_bound(components.begin(), components.end(), entityID,
-                             [](const T& component, EntityID entityID) { return component.entityID < entityID; });
+        if (observed() && getComponent(entityID)) {
+            notifyRemoved(entityID);
+        }
+
+        if constexpr (archetype) {
+            return archetypes && archetypes->remove(ComponentContainerID::get<T>(), entityID);
+        } else if constexpr (sparse) {
+            auto position = index.get(entityID);
+            if (position == SparseIndex::npos || components[position].entityID != entityID) {
+                return false;
+            }
+
+            if (position != components.size() - 1) {
+                components[position] = std::move(components.back());
+                index.set(components[position].entityID, position);
+            }
 
-        if (componentIt != components.end() && componentIt->entityID == entityID) {
-            components.erase(componentIt);
+            components.pop_back();
+            index.reset(entityID);
             return true;
-        }
+        } else {
+            auto componentIt = lowerBound(entityID);
 
-        return false;
+            if (componentIt != components.end() && componentIt->entityID == entityID) {
+                components.erase(componentIt);
+                return true;
+            }
+
+            return false;
+        }
     }
 
     // used internally as a method to delete all components from given entity and in dependency system.
     bool genericDeleteComponent(EntityID entityID) override{ return deleteComponent(entityID); }
 
+    // deletes components of all given entities, see ComponentContainerBase. Linear in size of container.
+    size_t genericDeleteComponents(std::span<const EntityID> entities) override {
+        if constexpr (archetype || sparse) {
+            auto deleted = size_t{0};
+            for (auto entity : entities) {
+                deleted += deleteComponent(entity) ? 1 : 0;
+            }
+            return deleted;
+        } else {
+            if (observed()) {
+                for (auto entity : entities) {
+                    if (getComponent(entity)) {
+                        notifyRemoved(entity);
+                    }
+                }
+            }
+
+            // both components and entities are sorted, so single pass finds all of them
+            auto next = entities.begin();
+            auto kept = components.begin();
+            for (auto it = components.begin(); it != components.end(); it++) {
+                while (next != entities.end() && *next < it->entityID) {
+                    next++;
+                }
+
+                if (next != entities.end() && *next == it->entityID) {
+                    continue;
+                }
+
+                if (kept != it) {
+                    *kept = std::move(*it);
+                }
+                kept++;
+            }
+
+            auto deleted = (size_t)(components.end() - kept);
+            components.erase(kept, components.end());
+            return deleted;
+        }
+    }
+
     // Deletes all components
-    void clear() override { components.clear(); }
+    void clear() override {
+        if constexpr (archetype) {
+            if (archetypes) {
+                archetypes->clear(ComponentContainerID::get<T>());
+            }
+        }
+
+        components.clear();
+        if constexpr (sparse) {
+            index.clear();
+        }
+
+        notifyCleared();
+    }
 
     // returns new object of the same class as *this*.
     std::unique_ptr<ComponentContainerBase> getNewClassInstance() const override {
         return std::make_unique<ComponentContainer<T>>();
     }
 
+    void setArchetypeStorage(ArchetypeStorage& storage) override { archetypes = &storage; }
+
+    // position of entity's component in getAllComponents(), or SparseIndex::npos. Only for SparseSet storage.
+    uint32_t positionOf(EntityID entityID) {
+        static_assert(sparse, "Only SparseSet storage allows to reorder components");
+        auto position = index.get(entityID);
+        return position != SparseIndex::npos && components[position].entityID == entityID ? position : SparseIndex::npos;
+    }
+
+    // swaps positions of two components. Only for SparseSet storage, used by owning groups.
+    void swapComponents(uint32_t first, uint32_t second) {
+        static_assert(sparse, "Only SparseSet storage allows to reorder components");
+        if (first != second) {
+            std::swap(components[first], components[second]);
+            index.set(components[first].entityID, first);
+            index.set(components[second].entityID, second);
+        }
+    }
+
 private:
+    static constexpr bool sparse = storageOf<T>() == ComponentStorage::SparseSet;
+    static constexpr bool archetype = storageOf<T>() == ComponentStorage::Archetype;
+
     std::vector<T> components;
+
+    // used only by SparseSet storage
+    SparseIndex index;
+
+    // used only by Archetype storage
+    ArchetypeStorage* archetypes = nullptr;
+
+    // addComponent without notifying groups and observers
+    template <typename... Args>
+    T* insert(EntityID entityID, Args&&... args) {
+        if (entityID == 0) {
+            return nullptr;
+        }
+
+        if constexpr (archetype) {
+            return archetypes ? archetypes->add<T>(entityID, std::forward<Args>(args)...) : nullptr;
+        } else if constexpr (sparse) {
+            auto position = index.get(entityID);
+            if (position != SparseIndex::npos) {
+                components[position] = T(std::forward<Args>(args)...);
+            } else {
+                position = (uint32_t)components.size();
+                components.emplace_back(std::forward<Args>(args)...);
+                index.set(entityID, position);
+            }
+
+            components[position].entityID = entityID;
+            return &components[position];
+        } else {
+            auto place = lowerBound(entityID);
+
+            auto componentAlreadyExists = place != components.end() && place->entityID == entityID;
+            if (componentAlreadyExists) {
+                *place = T(std::forward<Args>(args)...);
+            } else {
+                place = components.insert(place, T(std::forward<Args>(args)...));
+            }
+
+            place->entityID = entityID;
+            return &*place;
+        }
+    }
+
+    typename std::vector<T>::iterator lowerBound(EntityID entityID) {
+        return std::lower_bound(components.begin(), components.end(), entityID,
+                                [](const T& component, EntityID entityID) { return component.entityID < entityID; });
+    }
 };
 }
@@ -5,7 +5,15 @@
 #include <unordered_map>
 #include <type_traits>
 #include <cassert>
+#include <algorithm>
+#include <tuple>
+#include <typeindex>
 #include "componentContainer.h"
+#include "archetypeStorage.h"
+#include "view.h"
+#include "group.h"
+#include "threadPool.h"
+#include "../utils/profiler.h"
 #include "entityID.h"
 #include "globalDefs.h"
 #include "componentContainerID.h"
@@ -33,12 +41,18 @@ public:
             entityID = component->entityID;
     }
 
+    // stamps component as changed, see ComponentManager::touch
     ComponentType* operator->() const;
-    operator ComponentType*() const { return operator->(); }
     ComponentType& operator*() const { return *operator->(); }
-    operator bool() const { return operator->(); }
+
+    // only look the component up, without stamping it, so that testing handle isn't a change
+    operator ComponentType*() const { return get(); }
+    operator bool() const { return get(); }
 
 private:
+    // returns current pointer to the component, looks it up again if it was relocated
+    ComponentType* get() const;
+
     EntityID entityID = 0;
     ComponentManager* componentManager;
     mutable ComponentType* componentPtr = nullptr;
@@ -76,14 +90,18 @@ public:
         containers.reserve(singleComponentContainerArchetypes().size());
         for (const auto& container : singleComponentContainerArchetypes()) {
             containers.emplace_back(container->getNewClassInstance());
+            containers.back()->setArchetypeStorage(archetypes);
+            containers.back()->tick = &changeTick;
         }
+
+        resolveDependencies();
     }
 
     // Returns ComponentHandle to the created component. If it failed to create new component, handle will point to
     //  nullptr. Arguments after entityID are forwarded to constructor of the created component.
     template <class T, class... Args>
     ComponentHandle<T> addComponent(EntityID entityID, Args&&... args) {
-        if (!entityExists(entityID) || !addDependencies(entityID, ComponentContainerID::get<T>())) {
+        if (!entityExists(entityID)) {
             return ComponentHandle<T>(*this, nullptr);
         }
 
@@ -94,28 +112,46 @@ public:
     // Deletes component owned by given entity. Returns true if it was deleted, false if it didn't exist.
     template <class T>
     bool deleteComponent(EntityID entityID) {
-        deleteDependentComponents(entityID, ComponentContainerID::get<T>());
         return getContainer<T>()->deleteComponent(entityID);
     }
 
-    template<class T>
+    // returns true if entity has any component which depends on its T component, see Depends.
+    template <class T>
     bool hasDependentComponents(EntityID entity) {
-        for (auto i = 0u; i < componentDependencies().size(); i++) {
-            for (auto j = 0u; j < componentDependencies()[i].size(); j++) {
-                if (componentDependencies()[i][j] == ComponentContainerID::get<T>()) {
-                    auto* container = (ComponentContainerBase*)containers[i];
-                    if (container->genericHasComponent(entity)) {
-                        return true;
-                    }
-                }
+        for (auto dependent : dependents[ComponentContainerID::get<T>()]) {
+            if (containers[dependent]->genericHasComponent(entity)) {
+                return true;
             }
         }
 
         return false;
     }
 
+    // calls observer(entity, component) whenever component of type T is added, replaced by addComponent, or removed.
+    // Removal is reported before the component is deleted, also when the whole entity is deleted, but not by clear().
+    // Component reference is valid only during the call. Returns ID which unobserve takes.
+    //
+    // comps.observe<SpriteComponent>(ComponentChange::Added, [&](EntityID entity, SpriteComponent& sprite) {...});
+    template <class T, class Function>
+    size_t observe(ComponentChange change, Function&& observer) {
+        auto container = getContainer<T>();
+        return container->observe(change, [container, observer = std::forward<Function>(observer)](EntityID entity) mutable {
+            // earlier observer could've deleted it, see resolveDependencies
+            if (auto component = container->getComponent(entity)) {
+                observer(entity, *component);
+            }
+        });
+    }
+
+    // removes observer registered by observe<T>. Returns false if there was no such observer.
+    template <class T>
+    bool unobserve(size_t observerID) {
+        return getContainer<T>()->unobserve(observerID);
+    }
+
     // Deletes all components
     void clear() {
+        archetypes.clear();
         for (auto& container : containers) {
             container->clear();
         }
@@ -128,15 +164,34 @@ public:
     }
 
     // returns pointer to component of type T, owned by entity specified by argument, or nullptr if it doesn't exists.
+    // Component is stamped as changed, unless T is const.
     template <class T>
     T* getComponent(EntityID entityID) {
-        return getContainer<T>()->getComponent(entityID);
+        return touch<T>(getContainer<std::remove_const_t<T>>()->getComponent(entityID));
+    }
+
+    // stamps component as changed in current tick, unless T is const. Returns the same pointer.
+    template <class T>
+    T* touch(T* component) {
+        if constexpr (!std::is_const_v<T>) {
+            if (component) {
+                component->changedTick = changeTick;
+            }
+        }
+        return component;
     }
 
-    // the same as getComponent, but returns ComponentHandle instead.
+    // current tick, which is stamped on added and changed components. See Changed and Added.
+    Tick tick() const { return changeTick; }
+
+    // starts new tick. Changes made from now on are visible to queries filtered with the previous tick.
+    void advanceTick() { changeTick++; }
+
+    // the same as getComponent, but returns ComponentHandle instead. Component is stamped as changed only when handle
+    // is dereferenced.
     template <class T>
     ComponentHandle<T> getComponentHandle(EntityID entityID) {
-        return ComponentHandle<T>(*this, getComponent<T>(entityID));
+        return ComponentHandle<T>(*this, const_cast<T*>(getComponent<const T>(entityID)));
     }
 
     // returns reference to container which contains all components of type T. This container should not be modified in
@@ -147,6 +202,42 @@ public:
         return getContainer<T>()->getAllComponents();
     }
 
+    // returns lazy range over all entities which have *at least* given types, see View. Unlike intersection, it
+    // doesn't allocate anything.
+    // for (auto [entity, position, movement] : comps.view<PositionComponent, MovementComponent>()) { ... }
+    // Types can be wrapped in Changed or Added, and then only entities whose component changed after tick since are
+    // visited.
+    template <typename... ComponentTypes>
+    View<ComponentTypes...> view(Tick since = 0) {
+        return View<ComponentTypes...>(*getContainer<ComponentOf<ComponentTypes>>()..., archetypes, since);
+    }
+
+    // returns persistent query over all entities which have *at least* given types, see Group. It's created on the
+    // first call and kept up to date from then on, so it should be preferred over view() for queries which run every
+    // frame over entities that are rarely changed.
+    template <typename... ComponentTypes>
+    Group<ComponentTypes...>& group() {
+        return *findOrCreateGroup<Group<ComponentTypes...>, ComponentTypes...>();
+    }
+
+    // like group(), but members are also kept at the front of containers of given types, in the same order, see
+    // OwningGroup. Returns nullptr if any of these types is already owned by another group.
+    template <typename... ComponentTypes>
+    OwningGroup<ComponentTypes...>* owningGroup() {
+        auto found = groups.find(typeid(OwningGroup<ComponentTypes...>));
+        if (found != groups.end()) {
+            return static_cast<OwningGroup<ComponentTypes...>*>(found->second.get());
+        }
+
+        if (((getContainer<ComponentOf<ComponentTypes>>()->owner != nullptr) || ...)) {
+            return nullptr;
+        }
+
+        auto group = findOrCreateGroup<OwningGroup<ComponentTypes...>, ComponentTypes...>();
+        ((getContainer<ComponentOf<ComponentTypes>>()->owner = group), ...);
+        return group;
+    }
+
     // given list of types, gets all entities which have *at least* these types and returns vector of convenient
     // helper classes that allow for access/modification of these types. Each element of vector corresponds to single
     // entity.
@@ -157,131 +248,195 @@ public:
     // components could be accessed like that:
     // comps.intersection<PositionComponent, MovementComponent>()[0].get<PositionComponent>().x = 5;
     // Order of Entities in returned vector is undefined.
+    // It's built on top of view(), which should be preferred in code that runs every frame. Large intersections are
+    // gathered in parallel, see parallelForEach.
     template <typename Head, typename... Tail>
     std::vector<IntersectionComponents<Head, Tail...>> intersection() {
-        auto& headComponents = getAllComponents<Head>();
+        ECS_PROFILE_ZONE("ComponentManager::intersection");
+        auto entities = view<Head, Tail...>();
+
+        auto toResult = [](const typename View<Head, Tail...>::value_type& components) {
+            IntersectionComponents<Head, Tail...> currentEntityRequiredComponents;
+            std::apply(
+                [&](EntityID entity, auto&... entityComponents) {
+                    currentEntityRequiredComponents.entityID = entity;
+                    (currentEntityRequiredComponents.set(entityComponents), ...);
+                },
+                components);
+            return currentEntityRequiredComponents;
+        };
 
         std::vector<IntersectionComponents<Head, Tail...>> results;
-        results.reserve(headComponents.size());
-        std::mutex resultsMutex;
-
-        auto worker = [&](size_t startIndex, size_t endIndex) {
-            for (auto i = startIndex; i <= endIndex; i++) {
-                IntersectionComponents<Head, Tail...> currentEntityRequiredComponents;
-                if (fillWithRequiredComponents<IntersectionComponents<Head, Tail...>, Tail...>(
-                        headComponents[i].entityID, currentEntityRequiredComponents)) {
-                    currentEntityRequiredComponents.set(headComponents[i]);
-                    currentEntityRequiredComponents.entityID = headComponents[i].entityID;
-                    std::lock_guard<std::mutex> guard(resultsMutex);
-                    results.push_back(currentEntityRequiredComponents);
-                }
+        if (!runInParallel(entities)) {
+            results.reserve(entities.sizeHint());
+            for (auto components : entities) {
+                results.push_back(toResult(components));
             }
-        };
+            return results;
+        }
 
-        worker(0, headComponents.size() - 1);
-        return results;
+        // every thread gathers its results separately, they're merged at the end
+        std::vector<std::vector<IntersectionComponents<Head, Tail...>>> threadResults(threadPool->size());
+        threadPool->run(entities.partCount(), [&](size_t part, size_t thread) {
+            for (auto components : entities.part(part)) {
+                threadResults[thread].push_back(toResult(components));
+            }
+        });
 
-        //size_t elemsPerThread = headComponents.size() / 4;
+        auto resultsCount = size_t{0};
+        for (const auto& partial : threadResults) {
+            resultsCount += partial.size();
+        }
 
-        //if (elemsPerThread < 24) {
-        //    worker(0, headComponents.size() - 1);
-        //    return results;
-        //}
+        results.reserve(resultsCount);
+        for (const auto& partial : threadResults) {
+            results.insert(results.end(), partial.begin(), partial.end());
+        }
 
-        //std::vector<std::thread> threads;
-        //for (auto i = 0; i < 4; i++) {
-        //    threads.push_back(std::thread{worker, elemsPerThread * i, elemsPerThread * (i + 1) - 1});
-        //}
-        //threads.push_back(
-        //    std::thread{worker, headComponents.size() - headComponents.size() % 4, headComponents.size() - 1});
+        return results;
+    }
 
-        //for (auto& thread : threads) {
-        //    thread.join();
-        //}
+    // calls function(entityID, A&, B&, ...) for every entity which has *at least* given types. If there are at least
+    // parallelThreshold candidates and thread pool is set, view is split into cache-sized parts which are processed
+    // by threads of the pool, and call returns when all of them are done. Function can be called concurrently, so it
+    // must not add or delete components, nor touch any shared state without synchronization.
+    // comps.parallelForEach<PositionComponent, MovementComponent>([](EntityID, auto& position, auto& movement) {...});
+    template <typename... ComponentTypes, typename Function>
+    void parallelForEach(Function&& function) {
+        ECS_PROFILE_ZONE("ComponentManager::parallelForEach");
+        auto entities = view<ComponentTypes...>();
+
+        if (!runInParallel(entities)) {
+            for (auto components : entities) {
+                std::apply(function, components);
+            }
+            return;
+        }
 
-        //return results;
+        threadPool->run(entities.partCount(), [&](size_t part, size_t) {
+            ECS_PROFILE_ZONE("ComponentManager::parallelForEach part");
+            for (auto components : entities.part(part)) {
+                std::apply(function, components);
+            }
+        });
     }
 
+    // sets pool used by parallelForEach and intersection. Without it, they run serially.
+    void setThreadPool(ThreadPool& threadPool) { this->threadPool = &threadPool; }
+
+    // minimal amount of candidate entities for which query is processed in parallel. Below that, overhead of
+    // dispatching work to other threads outweighs the gain.
+    void setParallelThreshold(size_t threshold) { parallelThreshold = threshold; }
+
     // Checks if pointer to the component is still valid, in very fast way. Pointer to the component could turn invalid
-    // if there was any addiction/deletion of any component which is the same type.
+    // if there was any addiction/deletion of any component which is the same type(or, for Archetype-stored types, any
+    // Archetype-stored component of the same entity).
     template <class T>
     bool validComponentPointer(T* componentPtr, EntityID entityID) {
-        auto& comps = getAllComponents<T>();
-        return !comps.empty() && &comps.front() <= componentPtr && componentPtr <= &comps.back() && componentPtr->entityID == entityID;
+        if constexpr (storageOf<T>() == ComponentStorage::Archetype) {
+            return componentPtr && componentPtr == getContainer<T>()->getComponent(entityID);
+        } else {
+            auto& comps = getAllComponents<T>();
+            return !comps.empty() && &comps.front() <= componentPtr && componentPtr <= &comps.back() &&
+                   componentPtr->entityID == entityID;
+        }
     }
 
     void setEntityManager(const EntityManager& entityManager);
 
 private:
+    ArchetypeStorage archetypes;
     std::vector<std::unique_ptr<ComponentContainerBase>> containers;
     const EntityManager* entityManager = nullptr;
-    bool entityExists(EntityID entity);
+    ThreadPool* threadPool = nullptr;
+    size_t parallelThreshold = 4096;
+    std::unordered_map<std::type_index, std::unique_ptr<GroupBase>> groups;
+    Tick changeTick = 1;
 
-    template <class T>
-    ComponentContainer<T>* getContainer() {
-        static_assert(std::is_base_of<Component<T>, T>::value, "T must be a component type!");
-        return (ComponentContainer<T>*)containers[ComponentContainerID::get<T>()].get();
-    }
+    // dependents[type] are types which depend on given type, see Depends
+    std::vector<std::vector<size_t>> dependents;
 
-    //adds all dependencies of 'of', and all of their dependencies.
-    bool addDependencies(EntityID entity, size_t of) {
-        if (componentDependencies().size() <= of)
-            return true;
-        
-        const auto& dependencies = componentDependencies()[of];
-        for (auto i = 0u; i < dependencies.size(); i++) {
-            if (!addDependencies(entity, dependencies[i])) {
-                return false;
-            }
+    // set while entities are deleted, as then there's no need to delete dependent components one by one
+    bool deletingEntities = false;
 
-            auto* currentDependencyContainer = (ComponentContainerBase*)containers[dependencies[i]].get();
+    // set while entities are cloned, as prototype already has all dependencies, which are cloned along with the rest
+    bool cloningEntities = false;
+    bool entityExists(EntityID entity);
 
-            if (!currentDependencyContainer->genericHasComponent(entity)) {
-                if (!currentDependencyContainer->genericAddComponent(entity)) {
-                    return false;
-                }
+    template <class GroupType, class... ComponentTypes>
+    GroupType* findOrCreateGroup() {
+        auto& group = groups[typeid(GroupType)];
+        if (!group) {
+            auto created = std::make_unique<GroupType>(getContainer<ComponentOf<ComponentTypes>>()...);
+
+            // entities are gathered first, as owning group reorders containers while it's filled
+            std::vector<EntityID> matching;
+            for (const auto& components : view<ComponentTypes...>()) {
+                matching.push_back(std::get<0>(components));
+            }
+            for (auto entity : matching) {
+                created->componentAdded(entity);
             }
+
+            (getContainer<ComponentOf<ComponentTypes>>()->groups.push_back(created.get()), ...);
+            group = std::move(created);
         }
 
-        return true;
+        return static_cast<GroupType*>(group.get());
     }
 
-    void deleteDependentComponents(EntityID entity, size_t on) {
-        for (auto i = 0u; i < componentDependencies().size(); i++) {
-            for (auto j = 0u; j < componentDependencies()[i].size(); j++) {
-                if (componentDependencies()[i][j] == on) {
-                    deleteDependentComponents(entity, i);
-
-                    auto* container = (ComponentContainerBase*)containers[i].get();
-                    container->genericDeleteComponent(entity);
-                }
-            }
+    // used before entity is deleted, as its Archetype-stored components are deleted at once, without containers
+    void notifyArchetypeRemoval(EntityID entity) {
+        // copied, as observers could change the archetype
+        auto types = archetypes.typesOf(entity);
+        for (auto type : std::vector<size_t>(types.begin(), types.end())) {
+            containers[type]->notifyRemoved(entity);
         }
     }
 
-    // Fills second argument with required components. Returns true if all required components belonging to given entity
-    // were found
-    template <typename IntersectComponents, typename Head, typename... Tail>
-    bool fillWithRequiredComponents(EntityID entityID, IntersectComponents& components) {
-        static_assert(std::is_base_of<Component<Head>, Head>::value,
-                      "Interseciton template parameters must all be descended from Component!");
+    template <class ViewType>
+    bool runInParallel(const ViewType& view) const {
+        return threadPool && threadPool->size() > 1 && view.sizeHint() >= parallelThreshold && view.partCount() > 1;
+    }
 
-        auto currentComponent = getComponent<Head>(entityID);
-        if (!currentComponent) {
-            return false;
-        }
+    template <class T>
+    ComponentContainer<T>* getContainer() {
+        static_assert(std::is_base_of<Component<T>, T>::value, "T must be a component type!");
+        return (ComponentContainer<T>*)containers[ComponentContainerID::get<T>()].get();
+    }
 
-        if (fillWithRequiredComponents<IntersectComponents, Tail...>(entityID, components)) {
-            components.set(*currentComponent);
-            return true;
-        }
+    // dependencies are kept by observers: adding component adds components it depends on, which in turn add their
+    // dependencies, and deleting component deletes components which depend on it. Each observer handles single
+    // dependency, so deleting component costs O(its dependents). If dependency can't be added, component is deleted
+    // again, so that addComponent fails.
+    void resolveDependencies() {
+        dependents.assign(containers.size(), {});
+        for (auto dependent = 0u; dependent < componentDependencies().size() && dependent < containers.size();
+             dependent++) {
+            for (auto dependency : componentDependencies()[dependent]) {
+                if (dependency >= containers.size()) {
+                    continue;
+                }
+                dependents[dependency].push_back(dependent);
 
-        return false;
-    }
+                containers[dependent]->observe(ComponentChange::Added, [this, dependent, dependency](EntityID entity) {
+                    auto container = containers[dependency].get();
+                    if (cloningEntities || container->genericHasComponent(entity)) {
+                        return;
+                    }
+
+                    if (!container->genericAddComponent(entity)) {
+                        containers[dependent]->genericDeleteComponent(entity);
+                    }
+                });
 
-    template <typename IntersectComponents>
-    bool fillWithRequiredComponents(EntityID, IntersectComponents) {
-        return true;
+                containers[dependency]->observe(ComponentChange::Removed, [this, dependent](EntityID entity) {
+                    if (!deletingEntities) {
+                        containers[dependent]->genericDeleteComponent(entity);
+                    }
+                });
+            }
+        }
     }
 
     template <class T> friend class ComponentRegistrator;
@@ -289,16 +444,19 @@ private:
     friend class Entity;
 };
 
-// implementation of method from ComponentHandle which depends on definition of ComponentManager.
+// implementation of methods from ComponentHandle which depend on definition of ComponentManager.
 template <class ComponentType>
-ComponentType* ComponentHandle<ComponentType>::operator->() const {
+ComponentType* ComponentHandle<ComponentType>::get() const {
     if (!componentManager)
         return nullptr;
 
-    if (componentManager->validComponentPointer(componentPtr, entityID))
-        return componentPtr;
-
-    componentPtr = componentManager->getComponent<ComponentType>(entityID);
+    if (!componentManager->validComponentPointer(componentPtr, entityID))
+        componentPtr = const_cast<ComponentType*>(componentManager->getComponent<const ComponentType>(entityID));
     return componentPtr;
 }
+
+template <class ComponentType>
+ComponentType* ComponentHandle<ComponentType>::operator->() const {
+    return componentManager ? componentManager->touch(get()) : nullptr;
+}
 }
@@ -1,30 +1,61 @@
 #include "ecs.h"
-#include <thread>
-#include "utils/timer.h"
+#include <chrono>
 
 using namespace EECS;
 
-ECS::ECS(const std::string& configFilename) : entities(components), tasks(*this) {
+ECS::ECS(const std::string& configFilename) : entities(components), tasks(*this), commands(entities, components) {
     components.setEntityManager(entities);
+    components.setThreadPool(threadPool);
+    commands.setThreadCount(threadPool.size());
+    events.setThreadCount(threadPool.size());
 
     if (!configFilename.empty()) {
         config.load(configFilename);
+        applyConfiguration();
     }
 }
 
 void ECS::run() {
-    Timer timer;
-    std::chrono::milliseconds elapsedTime{0};
+    applyConfiguration();
 
+    // time is measured between consecutive points in time, so none of it is lost to rounding or to work done between
+    // measurements, and Tasks don't drift
+    auto lastUpdate = std::chrono::steady_clock::now();
     while (!quit) {
-        auto durationUntilNextUpdateNecessary = tasks.update(elapsedTime);
-        auto timeSpentSinceLastUpdate = Timer{};
+        auto now = std::chrono::steady_clock::now();
+        auto durationUntilNextUpdateNecessary = tasks.update(now - lastUpdate);
+        lastUpdate = now;
 
         events.emit();
+        commands.playback();
 
-        std::this_thread::sleep_for(durationUntilNextUpdateNecessary - timeSpentSinceLastUpdate.elapsed());
-        elapsedTime = std::max(std::chrono::milliseconds(0), timer.reset());
+        waiter.waitUntil(now + durationUntilNextUpdateNecessary);
     }
+
+    logger.info("TaskScheduler: timing ", tasks.describeTiming());
+    logger.info("Main loop: wake-up ", waiter.describeStats());
+
+#if defined(ECS_PROFILING)
+    auto traceFile = config.get("profiler.traceFile", "logz/trace.json");
+    if (Profiler::get().exportChromeTrace(traceFile)) {
+        logger.info("Profiler: trace written to ", traceFile);
+    } else {
+        logger.error("Profiler: failed to write trace to ", traceFile);
+    }
+#endif
 }
 
 void ECS::stop() { quit = true; }
+
+void ECS::applyConfiguration() {
+    threadPool.resize(config.get("threadPool.threads", 0u));
+    commands.setThreadCount(threadPool.size());
+    events.setThreadCount(threadPool.size());
+    if (events.eventTypeCount() > config.get("eventQueue.maxEventTypes", 1024u)) {
+        logger.error("EventQueue: ", events.eventTypeCount(),
+                     " event types are registered, more than eventQueue.maxEventTypes");
+    }
+    components.setParallelThreshold(config.get("componentManager.parallelThreshold", 4096u));
+    waiter.setStrategy(Waiter::parseStrategy(config.get("mainLoop.waitStrategy", "hybrid")));
+    waiter.setSpinMargin(std::chrono::microseconds(config.get("mainLoop.spinMargin", 1000)));
+}
@@ -1,21 +1,34 @@
 #pragma once
 #include "../utils/config.h"
+#include "commandBuffer.h"
 #include "componentManager.h"
 #include "entityManager.h"
 #include "taskScheduler.h"
 #include "eventQueue.h"
+#include "threadPool.h"
+#include "../utils/waiter.h"
 
 namespace EECS {
 /** class that encapsulates whole ECS
 *
 * It ties all components together and manages it's configuration.
 * It measures delta time for TaskScheduler.
+*
+* Settings are applied when ECS is constructed with config file, and again when run() starts:
+*   threadPool.threads - amount of threads used for parallel work, 0 means one per hardware thread(default)
+*   componentManager.parallelThreshold - minimal amount of entities for which queries run in parallel(4096)
+*   eventQueue.maxEventTypes - limit of registered event types, exceeding it is logged as an error(1024)
+*   mainLoop.waitStrategy - how main loop waits for next update: sleep, hybrid(default) or busy, see Waiter
+*   mainLoop.spinMargin - how long before next update hybrid strategy starts spinning, in microseconds(1000)
+*   profiler.traceFile - where run() exports samples of Profiler when it ends, if ECS_PROFILING is defined
+*   (logz/trace.json)
 */
 class ECS {
 public:
     ECS(const std::string& configFilename = "");
 
-    // Runs main loop. Calls TaskScheduler::update periodically, feeding it with delta time.
+    // Runs main loop. Calls TaskScheduler::update periodically, feeding it with delta time. After tasks are updated and
+    // events emitted, plays back commands.
     void run();
 
     // Will stop main loop at the next iteration.
@@ -26,10 +39,21 @@ public:
     TaskScheduler tasks;
     EventQueue events;
 
+    // structural changes recorded here are applied at the end of every tick, see CommandBuffer
+    CommandBuffer commands;
+
     Configuration config;
     Logger logger{"MAIN"};
 
+    ThreadPool threadPool{1};
+
+    // waits between iterations of main loop, its stats tell how precisely updates are started
+    Waiter waiter;
+
 private:
     bool quit = false;
+
+    // applies settings described in class comment
+    void applyConfiguration();
 };
 }
@@ -51,7 +51,7 @@ public:
             cachedComponent = { ComponentContainerID::get<T>(), components->getComponent<T>(id) };
         }
 
-        return (T*)cachedComponent.second;
+        return components->touch((T*)cachedComponent.second);
     }
 
     template <class T>
@@ -62,7 +62,8 @@ public:
         if (cachedComponent.first != ComponentContainerID::get<T>() ||
             !components->validComponentPointer((T*)cachedComponent.second, id)) {
 
-            cachedComponent = { ComponentContainerID::get<T>(), components->getComponent<T>(id) };
+            // handle stamps component only when it's dereferenced
+            cachedComponent = { ComponentContainerID::get<T>(), (T*)components->getComponent<const T>(id) };
         }
 
         return ComponentHandle<T>{*components, (T*)cachedComponent.second};
@@ -2,5 +2,14 @@
 #include <cstdint>
 
 namespace EECS {
+// EntityID consists of index(lower 32 bits) and generation(upper 32 bits). Index of deleted entity is reused by
+// entities created later, but with incremented generation, so IDs of deleted entities never refer to living ones.
+// Index 0 is never used, so 0 is never a valid EntityID.
 using EntityID = uint64_t;
+
+inline constexpr uint32_t entityIndex(EntityID entity) { return (uint32_t)entity; }
+inline constexpr uint32_t entityGeneration(EntityID entity) { return (uint32_t)(entity >> 32); }
+inline constexpr EntityID makeEntityID(uint32_t index, uint32_t generation) {
+    return ((EntityID)generation << 32) | index;
+}
 }
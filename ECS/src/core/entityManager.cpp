@@ -1,12 +1,60 @@
 #include "entity.h"
+#include <algorithm>
+#include <utility>
 
 namespace EECS {
 
 Entity EntityManager::getEntity(EntityID entityID) { return {entityID, *this, componentManager}; }
 
 Entity EntityManager::addEntity() {
-    entityExistence[++lastEntity] = true;
-    return {lastEntity, *this, componentManager};
+    flushReservations();
+
+    auto index = uint32_t{0};
+    if (!freeIndices.empty()) {
+        index = freeIndices.back();
+        freeIndices.pop_back();
+    } else {
+        index = (uint32_t)slots.size();
+        slots.emplace_back();
+    }
+
+    slots[index].alive = true;
+    livingEntities++;
+    freeCursor = (int64_t)freeIndices.size();
+    return {makeEntityID(index, slots[index].generation), *this, componentManager};
+}
+
+EntityID EntityManager::reserveEntity() {
+    auto cursor = --freeCursor;
+    if (cursor >= 0) {
+        // each index is taken by only one thread, so it can be marked without locking
+        auto index = freeIndices[cursor];
+        slots[index].reserved = true;
+        return makeEntityID(index, slots[index].generation);
+    }
+
+    return makeEntityID((uint32_t)(slots.size() - cursor - 1), 0);
+}
+
+Entity EntityManager::createReservedEntity(EntityID entityID, EntityID prototype) {
+    flushReservations();
+
+    auto index = entityIndex(entityID);
+    if (index >= slots.size() || !slots[index].reserved || slots[index].generation != entityGeneration(entityID)) {
+        return {0, *this, componentManager};
+    }
+
+    slots[index].reserved = false;
+    slots[index].alive = true;
+    livingEntities++;
+
+    if (prototype != 0 && entityExists(prototype)) {
+        for (auto& container : componentManager.containers) {
+            container->cloneComponent(prototype, entityID);
+        }
+    }
+
+    return {entityID, *this, componentManager};
 }
 
 Entity EntityManager::cloneEntity(EntityID source) {
@@ -16,34 +64,133 @@ Entity EntityManager::cloneEntity(EntityID source) {
 
     Entity target = addEntity();
 
+    auto wasCloning = std::exchange(componentManager.cloningEntities, true);
+
     for (auto& container : componentManager.containers) {
         if (container) {
             container->cloneComponent(source, target);
         }
     }
 
+    componentManager.cloningEntities = wasCloning;
+
     return target;
 }
 
 bool EntityManager::deleteEntity(EntityID entityID) {
-    auto it = entityExistence.find(entityID);
-    if (it == entityExistence.end()) {
+    if (!entityExists(entityID)) {
         return false;
     }
 
+    auto wasDeleting = std::exchange(componentManager.deletingEntities, true);
+
+    // all Archetype-stored components are deleted at once, instead of moving entity through smaller archetypes
+    componentManager.notifyArchetypeRemoval(entityID);
+    componentManager.archetypes.removeEntity(entityID);
+
     for (auto& container : componentManager.containers) {
         container->genericDeleteComponent(entityID);
     }
 
-    entityExistence.erase(it);
+    componentManager.deletingEntities = wasDeleting;
+
+    release(entityID);
     return true;
 }
 
+std::vector<EntityID> EntityManager::spawnBatch(size_t count, EntityID prototype) {
+    std::vector<EntityID> spawned;
+    if (prototype != 0 && !entityExists(prototype)) {
+        return spawned;
+    }
+
+    spawned.reserve(count);
+    for (auto i = 0u; i < count; i++) {
+        spawned.push_back(addEntity());
+    }
+    std::sort(spawned.begin(), spawned.end());
+
+    if (prototype != 0) {
+        // otherwise dependencies would be added to recipients before their containers are cloned
+        auto wasCloning = std::exchange(componentManager.cloningEntities, true);
+
+        for (auto& container : componentManager.containers) {
+            container->cloneComponents(prototype, spawned);
+        }
+
+        componentManager.cloningEntities = wasCloning;
+    }
+
+    return spawned;
+}
+
+size_t EntityManager::destroyBatch(std::span<const EntityID> entities) {
+    std::vector<EntityID> destroyed;
+    destroyed.reserve(entities.size());
+    for (auto entity : entities) {
+        if (entityExists(entity)) {
+            destroyed.push_back(entity);
+        }
+    }
+    std::sort(destroyed.begin(), destroyed.end());
+    destroyed.erase(std::unique(destroyed.begin(), destroyed.end()), destroyed.end());
+
+    auto wasDeleting = std::exchange(componentManager.deletingEntities, true);
+
+    for (auto entity : destroyed) {
+        componentManager.notifyArchetypeRemoval(entity);
+        componentManager.archetypes.removeEntity(entity);
+    }
+
+    for (auto& container : componentManager.containers) {
+        container->genericDeleteComponents(destroyed);
+    }
+
+    componentManager.deletingEntities = wasDeleting;
+
+    for (auto entity : destroyed) {
+        release(entity);
+    }
+
+    return destroyed.size();
+}
+
+void EntityManager::release(EntityID entityID) {
+    flushReservations();
+
+    // new generation makes all copies of this ID stale
+    auto& slot = slots[entityIndex(entityID)];
+    slot.alive = false;
+    slot.generation++;
+    livingEntities--;
+    freeIndices.push_back(entityIndex(entityID));
+    freeCursor = (int64_t)freeIndices.size();
+}
+
+void EntityManager::flushReservations() {
+    auto cursor = freeCursor.load();
+    if (cursor == (int64_t)freeIndices.size()) {
+        return;
+    }
+
+    // reserved indices are neither free nor alive until createReservedEntity is called
+    if (cursor < 0) {
+        freeIndices.clear();
+        slots.resize(slots.size() - cursor, Slot{0, false, true});
+    } else {
+        freeIndices.resize(cursor);
+    }
+    freeCursor = (int64_t)freeIndices.size();
+}
+
 void EntityManager::clear() {
-    for (auto entityEntry : entityExistence) {
-        deleteEntity(entityEntry.first);
+    std::vector<EntityID> living;
+    for (auto index = 1u; index < slots.size(); index++) {
+        if (slots[index].alive) {
+            living.push_back(makeEntityID(index, slots[index].generation));
+        }
     }
 
-    entityExistence.clear();
+    destroyBatch(living);
 }
 }
@@ -1,15 +1,23 @@
 #pragma once
-#include <unordered_map>
+#include <atomic>
+#include <span>
+#include <vector>
 #include "componentManager.h"
 
 namespace EECS {
 class Entity;
 
+// Creates and deletes entities. Indices of deleted entities are reused(see EntityID), so memory used by sparse
+// indices stays proportional to the amount of entities alive at once, not to the amount ever created.
 class EntityManager {
 public:
     explicit EntityManager(ComponentManager& componentManager) : componentManager(componentManager) {}
 
-    bool entityExists(EntityID entityID) const { return entityExistence.find(entityID) != entityExistence.end(); }
+    // O(1). False for IDs of deleted entities, even if their index is used by other entity now, and for reserved ones.
+    bool entityExists(EntityID entityID) const {
+        auto index = entityIndex(entityID);
+        return index < slots.size() && slots[index].alive && slots[index].generation == entityGeneration(entityID);
+    }
 
     Entity getEntity(EntityID entityID);
 
@@ -19,9 +27,50 @@ public:
     bool deleteEntity(EntityID entityID);
     void clear();
 
+    // creates count entities with copies of all components of prototype(or without any, if it's 0) and returns their
+    // IDs, in ascending order. Each container is updated once for the whole batch, instead of once per entity.
+    std::vector<EntityID> spawnBatch(size_t count, EntityID prototype = 0);
+
+    // deletes all given entities, updating each container once. Returns amount of entities which existed.
+    size_t destroyBatch(std::span<const EntityID> entities);
+
+    // returns ID for entity which will be created later by createReservedEntity. Safe to call from many threads at once,
+    // but not together with other methods. Used by CommandBuffer, so that commands can refer to entities which don't
+    // exist yet.
+    EntityID reserveEntity();
+
+    // creates entity with ID returned by reserveEntity, with copies of components of prototype if it isn't 0. Returns
+    // invalid Entity if ID wasn't reserved.
+    Entity createReservedEntity(EntityID entityID, EntityID prototype = 0);
+
+    // amount of living entities
+    size_t size() const { return livingEntities; }
+
 private:
-    std::unordered_map<EntityID, bool> entityExistence;
-    EntityID lastEntity = 0;
+    struct Slot {
+        uint32_t generation = 0;
+        bool alive = false;
+        bool reserved = false;
+    };
+
+    // indexed by entityIndex. Slot 0 is never used, so that 0 is never valid EntityID.
+    std::vector<Slot> slots = std::vector<Slot>(1);
+
+    // indices of deleted entities, to be reused by new ones
+    std::vector<uint32_t> freeIndices;
+
+    // reserveEntity takes free indices from the back of freeIndices by decrementing this. Negative value -n means that
+    // n new indices were reserved past the end of slots.
+    std::atomic<int64_t> freeCursor = 0;
+
+    size_t livingEntities = 0;
+
     ComponentManager& componentManager;
+
+    // marks index of deleted entity as free
+    void release(EntityID entityID);
+
+    // makes slots and freeIndices reflect reservations made since the last call
+    void flushReservations();
 };
 }
@@ -5,6 +5,7 @@
 #include "singleEventQueue.h"
 #include "globalDefs.h"
 #include "event.h"
+#include "../utils/profiler.h"
 
 namespace EECS {
 /** \brief stores pending messages of arbitrary amount of numbers
@@ -14,6 +15,22 @@ namespace EECS {
 *
 * receiver method returns true if event is to spread further into
 * lower-priority receivers, or false if it should vanish.
+*
+* Instead of receive(EventType&), receiver can have receive(std::span<EventType>), which gets all pending events
+* of the type in one call. If it returns bool, result applies to the whole batch. It can also consume single events:
+* then it moves events which spread further to the front of the span and returns their amount.
+*
+* Receivers are connected at runtime, and each of them is called through a function instantiated for its static
+* type, so per-event receiver costs one indirect call per event, and batch receiver one per batch.
+*
+* Each event goes through all receivers of its type before the next event is received. If any receiver of the type
+* handles batches, order changes for the whole type: each receiver gets all events which weren't consumed by
+* receivers before it, and only then the next receiver is called.
+*
+* Events can be pushed from threads of ECS's ThreadPool and from the main thread at once, as each thread appends to
+* its own buffer, so producers never wait for each other. Buffers are kept between emits, so pushing doesn't allocate
+* once they've grown. Events of a single thread are received in order in which they were pushed. Events pushed while
+* events of the same type are emitted are received on the next emit.
 */
 class EventQueue {
 public:
@@ -26,6 +43,7 @@ public:
 
     /** \brief emits all events in system at once, type by type. */
     void emit() {
+        ECS_PROFILE_ZONE("EventQueue::emit");
         for (auto& eventType : eventQueues) {
             if (eventType) {
                 eventType->emit();
@@ -60,7 +78,8 @@ public:
     *
     * \param receiver object that will receive events of EventType type
     *
-    * Receiver can be any class. Only requirment is possessing receive(const EventType&) method.
+    * Receiver can be any class. Only requirment is possessing receive(EventType&) or
+    * receive(std::span<EventType>) method.
     * Receiver will be called every time event of this type will be emited. Single class can receive arbitrary
     * amount of event types.
     */
@@ -69,11 +88,23 @@ public:
         getQueue<EventType>()->connect(reciever, priority);
     }
 
+    /** \brief connect receiver to events of particular type which concern given entity
+    *
+    * \param entity entity which events will be received, has to be listed by entities() method of EventType
+    *
+    * Only events which list the entity are routed to the receiver, so it isn't called for every event of the type.
+    * Such receivers get events before ones connected to all events of the type.
+    */
+    template <typename EventType, typename RecieverType>
+    void connect(RecieverType& reciever, EntityID entity, int priority = 0) {
+        getQueue<EventType>()->connect(reciever, entity, priority);
+    }
+
     /** \brief disconnect receiver from particular event type
     *
     * \param receiver object that will be disconnected of EventType events.
     *
-    * Receiver still can receive other events.
+    * Receiver still can receive other events. Its subscriptions to particular entities are disconnected too.
     */
     template <typename EventType, typename RecieverType>
     void disconnect(RecieverType& reciever) {
@@ -83,10 +114,18 @@ public:
         getQueue<EventType>()->disconnect(reciever);
     }
 
+    /** \brief disconnect receiver from events of particular type which concern given entity */
+    template <typename EventType, typename RecieverType>
+    void disconnect(RecieverType& reciever, EntityID entity) {
+        if (eventQueues.empty())
+            return;
+
+        getQueue<EventType>()->disconnect(reciever, entity);
+    }
+
     template <typename EventType, typename ReceiverType>
     void setPriority(ReceiverType& obj, int priority) {
-        getQueue<EventType>()->disconnect(obj);
-        getQueue<EventType>()->connect(obj, priority);
+        getQueue<EventType>()->setPriority(obj, priority);
     }
 
     void clear() {
@@ -95,6 +134,19 @@ public:
         }
     }
 
+    // amount of event types. All of them are registered before main(), so table of queues is complete once it's
+    // constructed and never grows.
+    size_t eventTypeCount() const { return eventQueues.size(); }
+
+    // has to be at least the amount of threads which push events. Must not be called while events are pushed.
+    void setThreadCount(size_t threadCount) {
+        for (auto& queue : eventQueues) {
+            if (queue) {
+                queue->setThreadCount(threadCount);
+            }
+        }
+    }
+
 private:
     std::vector<std::unique_ptr<SingleEventQueueBase>> eventQueues;
 
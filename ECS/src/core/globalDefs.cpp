@@ -10,6 +10,7 @@ using namespace EECS;
 size_t EventID::counter = 0;
 size_t ComponentContainerID::counter = 0;
 size_t TaskID::counter = 0;
+size_t ResourceID::counter = 0;
 
 std::vector<std::unique_ptr<ComponentContainerBase>>& EECS::singleComponentContainerArchetypes() {
     static std::vector<std::unique_ptr<ComponentContainerBase>> archetypes;
@@ -0,0 +1,228 @@
+#pragma once
+#include <cstddef>
+#include <iterator>
+#include <tuple>
+#include <vector>
+#include "componentContainer.h"
+#include "sparseIndex.h"
+#include "view.h"
+
+namespace EECS {
+
+/** \brief persistent query over all entities which have *at least* given component types
+*
+* Obtained by ComponentManager::group<A, B, C>(). Unlike View, it doesn't search for matching entities while
+* iterating - it keeps list of them, which is updated whenever component of one of the types is added or deleted.
+* So iterating it costs only lookups of components of its members, which pays off for queries that run every frame
+* over entities which rarely change their composition. Elements are the same as View's:
+*
+* for (auto [entity, position, size] : ecs.components.group<PositionComponent, SizeComponent>()) {
+*     ...
+* }
+*
+* Like in View, components requested as non-const are stamped as changed when iterator is dereferenced. Order of
+* entities is undefined. Components of requested types must not be added or deleted while iterating.
+*/
+template <typename... ComponentTypes>
+class Group : public GroupBase {
+    static_assert(sizeof...(ComponentTypes) > 0, "Group needs at least one component type");
+    static_assert(!(QueryTerm<ComponentTypes>::filtered || ...), "Changed and Added filters are supported only by View");
+
+public:
+    using value_type = std::tuple<EntityID, typename QueryTerm<ComponentTypes>::Reference...>;
+
+    class Iterator {
+    public:
+        using value_type = Group::value_type;
+        using difference_type = std::ptrdiff_t;
+
+        Iterator() = default;
+
+        value_type operator*() const {
+            auto entity = group->members[index];
+            auto tick = std::get<0>(group->containers)->currentTick();
+            return value_type{entity, access<ComponentTypes>(*std::get<ComponentContainer<ComponentOf<ComponentTypes>>*>(
+                                                                  group->containers)->getComponent(entity),
+                                                              tick)...};
+        }
+
+        Iterator& operator++() {
+            index++;
+            return *this;
+        }
+
+        void operator++(int) { ++*this; }
+
+        bool operator==(std::default_sentinel_t) const { return index >= group->members.size(); }
+
+    private:
+        const Group* group = nullptr;
+        size_t index = 0;
+
+        explicit Iterator(const Group& group) : group(&group) {}
+
+        friend class Group;
+    };
+
+    explicit Group(ComponentContainer<ComponentOf<ComponentTypes>>*... containers) : containers(containers...) {}
+
+    Iterator begin() const { return Iterator(*this); }
+    std::default_sentinel_t end() const { return {}; }
+
+    size_t size() const { return members.size(); }
+    bool empty() const { return members.empty(); }
+    const std::vector<EntityID>& entities() const { return members; }
+
+    bool contains(EntityID entity) const {
+        auto position = positions.get(entity);
+        return position != SparseIndex::npos && members[position] == entity;
+    }
+
+    void componentAdded(EntityID entity) override {
+        if (!contains(entity) && hasAll(entity)) {
+            positions.set(entity, (uint32_t)members.size());
+            members.push_back(entity);
+        }
+    }
+
+    void componentRemoved(EntityID entity) override {
+        if (!contains(entity)) {
+            return;
+        }
+
+        // fill the hole with the last member
+        auto position = positions.get(entity);
+        members[position] = members.back();
+        positions.set(members[position], position);
+        members.pop_back();
+        positions.reset(entity);
+    }
+
+    void cleared() override {
+        for (auto entity : members) {
+            positions.reset(entity);
+        }
+        members.clear();
+    }
+
+private:
+    std::tuple<ComponentContainer<ComponentOf<ComponentTypes>>*...> containers;
+    std::vector<EntityID> members;
+    SparseIndex positions;
+
+    bool hasAll(EntityID entity) const {
+        return ((std::get<ComponentContainer<ComponentOf<ComponentTypes>>*>(containers)->getComponent(entity) != nullptr) &&
+                ...);
+    }
+};
+
+/** \brief group which also owns containers of its component types
+*
+* Obtained by ComponentManager::owningGroup<A, B, C>(). Members are kept at the front of each owned container, in the
+* same order, so iterating it is a straight walk over parallel arrays, without any lookups or checks. Keeping them
+* there costs a few swaps whenever entity joins or leaves the group.
+*
+* Only SparseSet-stored types can be owned, since order of Sorted containers is fixed by EntityID, and each type can be
+* owned by a single group.
+*/
+template <typename... ComponentTypes>
+class OwningGroup : public GroupBase {
+    static_assert(sizeof...(ComponentTypes) > 0, "Group needs at least one component type");
+    static_assert(!(QueryTerm<ComponentTypes>::filtered || ...), "Changed and Added filters are supported only by View");
+    static_assert(((storageOf<ComponentOf<ComponentTypes>>() == ComponentStorage::SparseSet) && ...),
+                  "Only SparseSet-stored components can be owned by a group");
+
+    using First = ComponentOf<std::tuple_element_t<0, std::tuple<ComponentTypes...>>>;
+
+public:
+    using value_type = std::tuple<EntityID, typename QueryTerm<ComponentTypes>::Reference...>;
+
+    class Iterator {
+    public:
+        using value_type = OwningGroup::value_type;
+        using difference_type = std::ptrdiff_t;
+
+        Iterator() = default;
+
+        value_type operator*() const {
+            return value_type{std::get<First*>(arrays)[index].entityID,
+                              access<ComponentTypes>(std::get<ComponentOf<ComponentTypes>*>(arrays)[index], tick)...};
+        }
+
+        Iterator& operator++() {
+            index++;
+            return *this;
+        }
+
+        void operator++(int) { ++*this; }
+
+        bool operator==(std::default_sentinel_t) const { return index >= end; }
+
+    private:
+        std::tuple<ComponentOf<ComponentTypes>*...> arrays;
+        size_t index = 0;
+        size_t end = 0;
+        Tick tick = 0;
+
+        explicit Iterator(const OwningGroup& group)
+            : arrays(std::get<ComponentContainer<ComponentOf<ComponentTypes>>*>(group.containers)
+                         ->getAllComponents()
+                         .data()...),
+              end(group.count), tick(std::get<0>(group.containers)->currentTick()) {}
+
+        friend class OwningGroup;
+    };
+
+    explicit OwningGroup(ComponentContainer<ComponentOf<ComponentTypes>>*... containers) : containers(containers...) {}
+
+    Iterator begin() const { return Iterator(*this); }
+    std::default_sentinel_t end() const { return {}; }
+
+    size_t size() const { return count; }
+    bool empty() const { return count == 0; }
+
+    bool contains(EntityID entity) const {
+        auto position = std::get<ComponentContainer<First>*>(containers)->positionOf(entity);
+        return position != SparseIndex::npos && position < count;
+    }
+
+    void componentAdded(EntityID entity) override {
+        if (contains(entity) || !hasAll(entity)) {
+            return;
+        }
+
+        (moveTo<ComponentOf<ComponentTypes>>(entity, (uint32_t)count), ...);
+        count++;
+    }
+
+    void componentRemoved(EntityID entity) override {
+        if (!contains(entity)) {
+            return;
+        }
+
+        // last member takes its place
+        count--;
+        (moveTo<ComponentOf<ComponentTypes>>(entity, (uint32_t)count), ...);
+    }
+
+    void cleared() override { count = 0; }
+
+private:
+    std::tuple<ComponentContainer<ComponentOf<ComponentTypes>>*...> containers;
+
+    // members are the first count components of each container
+    size_t count = 0;
+
+    bool hasAll(EntityID entity) const {
+        return ((std::get<ComponentContainer<ComponentOf<ComponentTypes>>*>(containers)->positionOf(entity) !=
+                 SparseIndex::npos) &&
+                ...);
+    }
+
+    template <typename T>
+    void moveTo(EntityID entity, uint32_t position) const {
+        auto container = std::get<ComponentContainer<T>*>(containers);
+        container->swapComponents(container->positionOf(entity), position);
+    }
+};
+}
@@ -1,6 +1,15 @@
 #pragma once
+#include <algorithm>
+#include <cassert>
+#include <concepts>
+#include <iterator>
+#include <memory>
+#include <span>
+#include <type_traits>
+#include <unordered_map>
 #include <vector>
-#include "FastDelegate.h"
+#include "entityID.h"
+#include "threadPool.h"
 
 namespace EECS {
 class SingleEventQueueBase {
@@ -9,62 +18,149 @@ public:
     virtual ~SingleEventQueueBase() {}
     virtual std::unique_ptr<SingleEventQueueBase> getNewClassInstance() const = 0;
     virtual void clear() = 0;
+    virtual void setThreadCount(size_t threadCount) = 0;
+};
+
+// receiver which handles whole batch of events in one call, see SingleEventQueue. It returns either bool, which
+// applies to the whole batch, or amount of events which spread further, which it has moved to the front of the span.
+template <typename ReceiverType, typename EventType>
+concept BatchReceiver = requires(ReceiverType& receiver, std::span<EventType> events) {
+    { receiver.receive(events) } -> std::convertible_to<size_t>;
+};
+
+// event which concerns particular entities, listed by its entities() method, so receivers can subscribe to events of
+// single entity
+template <typename EventType>
+concept KeyedEvent = requires(const EventType& event) {
+    { *std::begin(event.entities()) } -> std::convertible_to<EntityID>;
 };
 
 template <typename EventType>
 class SingleEventQueue : public SingleEventQueueBase {
+    // delivers events to the receiver, moves ones which spread further to the front and returns their amount
+    using Dispatch = size_t (*)(void* receiver, EventType* events, size_t count);
+
     struct DelegateEntry {
-        fastdelegate::FastDelegate1<EventType&, bool> delegate;
+        void* receiver;
+        Dispatch dispatch;
         int priority;
+        bool batch;
+    };
+
+    // aligned, so that threads don't write to the same cache line
+    struct alignas(64) ThreadEvents {
+        std::vector<EventType> events;
     };
 
 public:
+    SingleEventQueue() : buffers(1) {}
+
+    /* events of each thread are emitted in order in which they were pushed, thread after thread. Receivers are
+     * called in order of priority. Each event goes through all receivers before the next one, unless any receiver
+     * handles batches - then each receiver gets all events which weren't consumed by receivers before it, before the
+     * next receiver is called.
+     *
+     * Pending events are moved to the front buffer before they're dispatched, so events pushed by receivers land in
+     * emptied back buffers and are emitted next time. Buffers keep their capacity, so once they've grown to the
+     * usual amount of events, neither pushing nor emitting allocates.
+     *
+     * Receivers subscribed to entities of an event get it before all other receivers. */
     void emit() override {
-        for (auto& event : events) {
-            for (auto& delegate : delegates) {
-                if (!delegate.delegate(event)) {
-                    break;
+        front.swap(buffers[0].events);
+        for (auto i = 1u; i < buffers.size(); i++) {
+            std::move(buffers[i].events.begin(), buffers[i].events.end(), std::back_inserter(front));
+            buffers[i].events.clear();
+        }
+
+        auto batched = std::any_of(delegates.begin(), delegates.end(), [](const auto& entry) { return entry.batch; });
+        if (batched) {
+            auto count = front.size();
+            if constexpr (KeyedEvent<EventType>) {
+                if (!routes.empty()) {
+                    count = route(count);
+                }
+            }
+            for (auto i = 0u; i < delegates.size() && count > 0; i++) {
+                count = delegates[i].dispatch(delegates[i].receiver, front.data(), count);
+            }
+        } else {
+            for (auto& event : front) {
+                auto spreads = true;
+                if constexpr (KeyedEvent<EventType>) {
+                    if (!routes.empty()) {
+                        spreads = routeEvent(event);
+                    }
+                }
+                for (auto i = 0u; i < delegates.size() && spreads; i++) {
+                    spreads = delegates[i].dispatch(delegates[i].receiver, &event, 1) == 1;
                 }
             }
         }
-        events.clear();
+        front.clear();
     }
 
-    void push(EventType&& event) { events.push_back(std::move(event)); }
+    void push(EventType&& event) { local().push_back(std::move(event)); }
 
     template <typename... Args>
     void emplace(Args&&... args) {
-        events.emplace_back(std::forward<Args>(args)...);
+        local().emplace_back(std::forward<Args>(args)...);
+    }
+
+    // buffers are only added, so that pending events aren't lost
+    void setThreadCount(size_t threadCount) override {
+        if (threadCount > buffers.size()) {
+            buffers.resize(threadCount);
+        }
     }
 
     template <typename ObjectType>
     void connect(ObjectType& obj, int priority) {
-        auto alreadyConnected = std::find_if(delegates.begin(), delegates.end(), [&obj](DelegateEntry& delegateEntry) {
-            return delegateEntry.delegate == fastdelegate::FastDelegate1<EventType&, bool>{&obj, &ObjectType::receive};
-        });
-        if (alreadyConnected != delegates.end()) {
-            return;
-        }
+        insert(delegates, obj, priority);
+    }
 
-        auto place = std::lower_bound(delegates.begin(), delegates.end(), priority,
-                                      [](const auto& delegate, int priority) { return delegate.priority < priority; });
-        delegates.insert(place, {fastdelegate::FastDelegate1<EventType&, bool>{&obj, &ObjectType::receive}, priority});
+    // receiver gets only events which concern given entity, see KeyedEvent
+    template <typename ObjectType>
+    void connect(ObjectType& obj, EntityID entity, int priority) {
+        static_assert(KeyedEvent<EventType>, "Only events which list their entities can be subscribed to by entity");
+        insert(routes[entity], obj, priority);
     }
 
+    // (re)connects receiver to all events with given priority, its subscriptions to entities aren't affected
+    template <typename ObjectType>
+    void setPriority(ObjectType& obj, int priority) {
+        erase(delegates, obj);
+        insert(delegates, obj, priority);
+    }
+
+    // disconnects receiver, including all of its subscriptions to entities
     template <typename ObjectType>
     void disconnect(ObjectType& obj) {
-        auto delegateIt = std::find_if(delegates.begin(), delegates.end(), [&obj](DelegateEntry& delegateEntry) {
-            return delegateEntry.delegate == fastdelegate::FastDelegate1<EventType&, bool>{&obj, &ObjectType::receive};
-        });
+        erase(delegates, obj);
+        for (auto route = routes.begin(); route != routes.end();) {
+            erase(route->second, obj);
+            route = route->second.empty() ? routes.erase(route) : std::next(route);
+        }
+    }
+
+    template <typename ObjectType>
+    void disconnect(ObjectType& obj, EntityID entity) {
+        auto route = routes.find(entity);
+        if (route == routes.end()) {
+            return;
+        }
 
-        if (delegateIt != delegates.end()) {
-            delegates.erase(delegateIt);
+        erase(route->second, obj);
+        if (route->second.empty()) {
+            routes.erase(route);
         }
     }
 
     void clear() override {
-        events.clear();
+        for (auto& buffer : buffers) {
+            buffer.events.clear();
+        }
         delegates.clear();
+        routes.clear();
     }
 
     // returns new object of the same class as *this*.
@@ -74,6 +170,112 @@ public:
 
 private:
     std::vector<DelegateEntry> delegates;
-    std::vector<EventType> events;
+
+    // back buffers, with events pushed by each thread, indexed by ThreadPool::currentThread()
+    std::vector<ThreadEvents> buffers;
+
+    // events which are being emitted
+    std::vector<EventType> front;
+
+    // receivers subscribed to events of particular entities, see connect(obj, entity, priority)
+    std::unordered_map<EntityID, std::vector<DelegateEntry>> routes;
+
+    // receivers of event which is being routed
+    std::vector<DelegateEntry> routed;
+
+    template <typename ObjectType>
+    static bool matches(const DelegateEntry& entry, ObjectType& obj) {
+        return entry.receiver == &obj && entry.dispatch == &dispatch<ObjectType>;
+    }
+
+    // keeps entries sorted by priority
+    template <typename ObjectType>
+    static void insert(std::vector<DelegateEntry>& entries, ObjectType& obj, int priority) {
+        auto connected = [&obj](const DelegateEntry& entry) { return matches(entry, obj); };
+        if (std::any_of(entries.begin(), entries.end(), connected)) {
+            return;
+        }
+
+        auto place = std::lower_bound(entries.begin(), entries.end(), priority,
+                                      [](const auto& delegate, int priority) { return delegate.priority < priority; });
+        entries.insert(place, {&obj, &dispatch<ObjectType>, priority, BatchReceiver<ObjectType, EventType>});
+    }
+
+    template <typename ObjectType>
+    static void erase(std::vector<DelegateEntry>& entries, ObjectType& obj) {
+        auto connected = [&obj](const DelegateEntry& entry) { return matches(entry, obj); };
+        entries.erase(std::remove_if(entries.begin(), entries.end(), connected), entries.end());
+    }
+
+    /* delivers first count events of front buffer to receivers subscribed to their entities, event by event. Moves
+     * events which weren't consumed to the front and returns their amount. */
+    size_t route(size_t count) {
+        auto kept = size_t{0};
+        for (auto i = size_t{0}; i < count; i++) {
+            if (routeEvent(front[i])) {
+                if (kept != i) {
+                    front[kept] = std::move(front[i]);
+                }
+                kept++;
+            }
+        }
+        return kept;
+    }
+
+    /* delivers event to receivers subscribed to its entities, returns false if it was consumed. Receiver subscribed to
+     * more than one entity of the event gets it once. */
+    bool routeEvent(EventType& event) {
+        routed.clear();
+        for (EntityID entity : event.entities()) {
+            auto route = routes.find(entity);
+            if (route != routes.end()) {
+                routed.insert(routed.end(), route->second.begin(), route->second.end());
+            }
+        }
+        std::stable_sort(routed.begin(), routed.end(),
+                         [](const auto& first, const auto& second) { return first.priority < second.priority; });
+
+        auto spreads = true;
+        for (auto i = routed.begin(); i != routed.end() && spreads; i++) {
+            auto duplicate = std::any_of(routed.begin(), i, [&](const DelegateEntry& entry) {
+                return entry.receiver == i->receiver && entry.dispatch == i->dispatch;
+            });
+            if (!duplicate) {
+                spreads = i->dispatch(i->receiver, &event, 1) == 1;
+            }
+        }
+        return spreads;
+    }
+
+    // instantiated for static type of the receiver, so its receive() is called directly and can be inlined
+    template <typename ObjectType>
+    static size_t dispatch(void* receiver, EventType* events, size_t count) {
+        auto& obj = *static_cast<ObjectType*>(receiver);
+        if constexpr (BatchReceiver<ObjectType, EventType>) {
+            auto kept = obj.receive(std::span<EventType>(events, count));
+            if constexpr (std::is_same_v<decltype(kept), bool>) {
+                return kept ? count : 0;
+            } else {
+                return std::min((size_t)kept, count);
+            }
+        } else {
+            auto kept = size_t{0};
+            for (auto i = size_t{0}; i < count; i++) {
+                if (obj.receive(events[i])) {
+                    if (kept != i) {
+                        events[kept] = std::move(events[i]);
+                    }
+                    kept++;
+                }
+            }
+            return kept;
+        }
+    }
+
+    std::vector<EventType>& local() {
+        auto thread = ThreadPool::currentThread();
+        assert(thread < buffers.size() && "Event pushed from thread which queue isn't prepared for, see setThreadCount");
+        return buffers[thread].events;
+    }
 };
 }
@@ -0,0 +1,65 @@
+#pragma once
+#include <array>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <vector>
+#include "entityID.h"
+
+namespace EECS {
+
+// Maps EntityID to position of its element in some dense array, in O(1).
+// Only index part of EntityID is used, so deleted entity maps to the same position as living entity which reuses its
+// index. If such stale IDs can be passed, check whether element at returned position belongs to the same entity.
+// Memory is allocated in pages of fixed size, only for ranges of entities that were actually used, so large and
+// scattered IDs don't cost one slot per every ID below them.
+class SparseIndex {
+public:
+    static constexpr uint32_t npos = std::numeric_limits<uint32_t>::max();
+    static constexpr size_t pageSize = 4096;
+
+    // returns position assigned to given entity, or npos if there is none.
+    uint32_t get(EntityID entity) const {
+        auto pageIndex = entityIndex(entity) / pageSize;
+        if (pageIndex >= pages.size() || !pages[pageIndex]) {
+            return npos;
+        }
+
+        return (*pages[pageIndex])[entityIndex(entity) % pageSize];
+    }
+
+    void set(EntityID entity, uint32_t position) {
+        auto pageIndex = entityIndex(entity) / pageSize;
+        if (pageIndex >= pages.size()) {
+            pages.resize(pageIndex + 1);
+        }
+
+        if (!pages[pageIndex]) {
+            pages[pageIndex] = std::make_unique<Page>();
+            pages[pageIndex]->fill(npos);
+        }
+
+        (*pages[pageIndex])[entityIndex(entity) % pageSize] = position;
+    }
+
+    void reset(EntityID entity) {
+        auto pageIndex = entityIndex(entity) / pageSize;
+        if (pageIndex < pages.size() && pages[pageIndex]) {
+            (*pages[pageIndex])[entityIndex(entity) % pageSize] = npos;
+        }
+    }
+
+    // forgets all positions. Pages are kept, so filling index again won't allocate.
+    void clear() {
+        for (auto& page : pages) {
+            if (page) {
+                page->fill(npos);
+            }
+        }
+    }
+
+private:
+    using Page = std::array<uint32_t, pageSize>;
+    std::vector<std::unique_ptr<Page>> pages;
+};
+}
@@ -1,8 +1,33 @@
 #include "task.h"
+#include <algorithm>
 #include "ecs.h"
 
 using namespace EECS;
 
 TaskBase::TaskBase(ECS& ecs) : ecs(ecs) {
-    frequency = std::chrono::milliseconds(ecs.config.get("task.defaultTaskFrequency", 16));
+    auto milliseconds = std::chrono::duration<double, std::milli>(ecs.config.get("task.defaultTaskFrequency", 16.0));
+    frequency = std::chrono::round<std::chrono::nanoseconds>(milliseconds);
+    maxCatchUp = ecs.config.get("task.maxCatchUp", 64ll);
+}
+
+void TaskBase::setRate(double updatesPerSecond) {
+    frequency = std::chrono::round<std::chrono::nanoseconds>(std::chrono::duration<double>(1.0 / updatesPerSecond));
+}
+
+double TaskBase::interpolation() const {
+    return frequency.count() > 0 ? (double)accumulatedTime.count() / frequency.count() : 0.0;
+}
+
+bool TaskAccess::conflictsWith(const TaskAccess& other) const {
+    if (!declared || !other.declared) {
+        return true;
+    }
+
+    auto writesAnyOf = [](const std::vector<size_t>& writes, const std::vector<size_t>& resources) {
+        return std::any_of(writes.begin(), writes.end(), [&](size_t written) {
+            return std::find(resources.begin(), resources.end(), written) != resources.end();
+        });
+    };
+
+    return writesAnyOf(writes, other.reads) || writesAnyOf(writes, other.writes) || writesAnyOf(other.writes, reads);
 }
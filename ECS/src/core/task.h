@@ -1,5 +1,11 @@
 #pragma once
+#include <algorithm>
 #include <chrono>
+#include <string>
+#include <typeinfo>
+#include <vector>
+#include "changeTick.h"
+#include "../utils/stringUtils.h"
 
 namespace EECS {
 class ECS;
@@ -18,6 +24,64 @@ private:
     static size_t counter;
 };
 
+// identifies resource - component or event type - which Tasks declare access to, see Task.
+class ResourceID {
+public:
+    template <typename T>
+    static size_t get() {
+        static size_t id = counter++;
+        return id;
+    }
+
+private:
+    static size_t counter;
+};
+
+// Task parameters which declare what resources Task accesses in update(), see Task.
+template <typename... Resources>
+struct Reads {};
+
+template <typename... Resources>
+struct Writes {};
+
+// Task parameter which makes update() always run on the thread which calls TaskScheduler::update, for example
+// because it uses window, which can't be used from other threads.
+struct MainThread {};
+
+// resources which Task accesses in update(). If nothing was declared, Task is assumed to access everything.
+struct TaskAccess {
+    bool declared = false;
+    bool mainThread = false;
+    std::vector<size_t> reads;
+    std::vector<size_t> writes;
+
+    // true if Tasks can't run concurrently, as at least one of them writes something that the other one accesses
+    bool conflictsWith(const TaskAccess& other) const;
+};
+
+// how late Task's updates were, compared to points in time they were due at with fixed timestep
+struct TaskTiming {
+    size_t updates = 0;
+
+    // updates skipped, because Task was due more times than its maxCatchUp in single TaskScheduler::update
+    size_t skippedUpdates = 0;
+
+    std::chrono::nanoseconds lastError{0};
+    std::chrono::nanoseconds maxError{0};
+    std::chrono::nanoseconds totalError{0};
+
+    std::chrono::nanoseconds meanError() const {
+        return updates > 0 ? totalError / (std::chrono::nanoseconds::rep)updates : std::chrono::nanoseconds(0);
+    }
+
+    void record(std::chrono::nanoseconds error) {
+        updates++;
+        lastError = error;
+        maxError = std::max(maxError, error);
+        totalError += error;
+    }
+};
+
 template <typename T>
 class TaskRegistrator {
 public:
@@ -32,9 +96,33 @@ public:
     /** \brief called at given frequency, derived class must implement it */
     virtual void update() = 0;
 
-    std::chrono::milliseconds frequency;
-    std::chrono::milliseconds accumulatedTime{0};
+    // sets frequency from amount of updates per second, which doesn't have to be whole, like 144Hz
+    void setRate(double updatesPerSecond);
+
+    // part of interval between updates which has already passed since the last one, in [0, 1). Render Task can use it
+    // to interpolate between the last two states computed by Task which runs with fixed timestep:
+    // ecs.tasks.getTask<PhysicsTask>()->interpolation()
+    double interpolation() const;
+
+    // interval between updates, in config: task.defaultTaskFrequency, in milliseconds(can be fractional)
+    std::chrono::nanoseconds frequency;
+    std::chrono::nanoseconds accumulatedTime{0};
+
+    // maximal amount of updates in single TaskScheduler::update. If Task is due more times, for example after long
+    // frame, the rest is skipped, so that it doesn't fall further and further behind. In config: task.maxCatchUp
+    long long maxCatchUp;
+    TaskTiming timing;
+
+    // tick of ComponentManager in which update() was called previously. Passed to view(), it makes Changed and Added
+    // filters visit only components which changed since then.
+    Tick lastUpdateTick = 0;
     ECS& ecs;
+
+    TaskAccess access;
+    std::string name;
+
+    // same as name, but lives as long as the program, so it can name zones of Profiler
+    const char* zoneName = "";
 };
 
 /** \brief implements independient portion of code, that is executed with some frequency
@@ -51,15 +139,45 @@ public:
 *   But Tasks are flexible, so you can use it to do any thing that should be done periodically.
 *
 *   By default, frequency will be once per game loop iteration(in config, task.defaultTaskFrequency).
+*
+*   Tasks can declare which components(or events, which they push) they read and write in update():
+*
+*   class MovementTask : public Task<MovementTask, Reads<MovementComponent>, Writes<PositionComponent>> {...};
+*
+*   TaskScheduler runs Tasks which don't conflict with each other concurrently. Tasks which don't declare anything
+*   are assumed to access everything, so they always run alone, on the main thread. Task which has to run on the main
+*   thread, for example because it uses window, should have MainThread among its parameters. Declaring Reads<> alone
+*   means that update() doesn't touch any resource.
 */
-template <typename Derived>
+template <typename Derived, typename... Access>
 class Task : public TaskBase {
 private:
-    Task(ECS& ecs) : TaskBase(ecs) { (void)taskRegistrator; }
+    Task(ECS& ecs) : TaskBase(ecs) {
+        (void)taskRegistrator;
+        (declare(Access{}), ...);
+        static const auto derivedName = typeName(typeid(Derived));
+        name = derivedName;
+        zoneName = derivedName.c_str();
+    }
+
+    template <typename... Resources>
+    void declare(Reads<Resources...>) {
+        access.declared = true;
+        (access.reads.push_back(ResourceID::get<Resources>()), ...);
+    }
+
+    template <typename... Resources>
+    void declare(Writes<Resources...>) {
+        access.declared = true;
+        (access.writes.push_back(ResourceID::get<Resources>()), ...);
+    }
+
+    void declare(MainThread) { access.mainThread = true; }
+
     static TaskRegistrator<Derived> taskRegistrator;
     friend Derived;
 };
 
-template <typename Derived>
-TaskRegistrator<Derived> Task<Derived>::taskRegistrator;
+template <typename Derived, typename... Access>
+TaskRegistrator<Derived> Task<Derived, Access...>::taskRegistrator;
 }
@@ -1,6 +1,8 @@
 #include "taskScheduler.h"
-#include "utils/timer.h"
+#include <algorithm>
+#include "utils/profiler.h"
 #include "task.h"
+#include "ecs.h"
 
 using namespace EECS;
 
@@ -10,28 +12,160 @@ TaskScheduler::~TaskScheduler() = default;
 
 void EECS::TaskScheduler::clear() { tasks.clear(); }
 
-std::chrono::milliseconds TaskScheduler::update(std::chrono::milliseconds elapsedTime) {
-    std::chrono::milliseconds nextTaskUpdate{std::chrono::milliseconds::max()};
-    Timer timeAlreadyElapsed;
+std::chrono::nanoseconds TaskScheduler::update(std::chrono::nanoseconds elapsedTime) {
+    ECS_PROFILE_ZONE("TaskScheduler::update");
 
-    for (auto& task : tasks) {
+    // find out how many times each task is due
+    pendingUpdates.assign(tasks.size(), 0);
+    auto rounds = 0ll;
+    for (auto i = 0u; i < tasks.size(); i++) {
+        auto& task = tasks[i];
         if (task == nullptr) {
             continue;
         }
 
-        task->accumulatedTime = std::clamp(task->accumulatedTime + elapsedTime + timeAlreadyElapsed.elapsed(),
-                                      std::chrono::milliseconds(0), std::chrono::milliseconds(1000));
+        if (task->frequency.count() <= 0) {
+            task->accumulatedTime = std::chrono::nanoseconds(0);
+            pendingUpdates[i] = 1;
+        } else {
+            task->accumulatedTime += std::max(elapsedTime, std::chrono::nanoseconds(0));
+            pendingUpdates[i] = task->accumulatedTime / task->frequency;
+            if (pendingUpdates[i] > task->maxCatchUp) {
+                auto skipped = pendingUpdates[i] - std::max(task->maxCatchUp, 0ll);
+                task->accumulatedTime -= skipped * task->frequency;
+                task->timing.skippedUpdates += skipped;
+                pendingUpdates[i] -= skipped;
+            }
+        }
+        rounds = std::max(rounds, pendingUpdates[i]);
+    }
+
+    for (auto round = 0ll; round < rounds; round++) {
+        dueTasks.clear();
+        for (auto i = 0u; i < pendingUpdates.size() && i < tasks.size(); i++) {
+            if (pendingUpdates[i] > round && tasks[i]) {
+                dueTasks.push_back(i);
+
+                // update was due when accumulated time reached frequency, the rest is how late it is
+                auto& task = *tasks[i];
+                if (task.frequency.count() > 0) {
+                    task.accumulatedTime -= task.frequency;
+                    task.timing.record(task.accumulatedTime);
+                }
+            }
+        }
+
+        buildStages();
+        if (round == 0 && stages != schedule) {
+            schedule = stages;
+            engine.logger.info("TaskScheduler: new schedule ", describeSchedule());
+        }
+
+        // changes made by each stage are visible to the next ones, see Changed
+        for (const auto& stage : stages) {
+            runStage(stage);
+            engine.components.advanceTick();
+        }
+    }
+
+    // without Tasks nothing is ever due, but interval is added to current time, so it can't be infinite
+    auto nextTaskUpdate = std::chrono::nanoseconds(idleInterval);
+    auto anyTask = false;
+    for (auto& task : tasks) {
+        if (task) {
+            nextTaskUpdate = anyTask ? std::min(nextTaskUpdate, task->frequency - task->accumulatedTime)
+                                     : task->frequency - task->accumulatedTime;
+            anyTask = true;
+        }
+    }
+
+    return nextTaskUpdate;
+}
+
+std::string TaskScheduler::describeSchedule() const {
+    std::string description;
+    for (const auto& stage : schedule) {
+        description += description.empty() ? "[" : " -> [";
+        for (auto i = 0u; i < stage.size(); i++) {
+            auto id = stage[i];
+            description += i > 0 ? ", " : "";
+            description += id < tasks.size() && tasks[id] ? tasks[id]->name : "#" + std::to_string(id);
+        }
+        description += "]";
+    }
+
+    return description;
+}
+
+std::string TaskScheduler::describeTiming() const {
+    auto milliseconds = [](std::chrono::nanoseconds time) {
+        return std::to_string(std::chrono::duration<double, std::milli>(time).count()) + "ms";
+    };
+
+    std::string description;
+    for (const auto& task : tasks) {
+        if (task) {
+            const auto& timing = task->timing;
+            description += "\n" + task->name + ": " + std::to_string(timing.updates) + " updates, " +
+                           std::to_string(timing.skippedUpdates) + " skipped, error mean " +
+                           milliseconds(timing.meanError()) + ", max " + milliseconds(timing.maxError);
+        }
+    }
+
+    return description;
+}
+
+void TaskScheduler::buildStages() {
+    for (auto& stage : stages) {
+        stage.clear();
+    }
+    stageOf.resize(tasks.size());
 
-        while (task->accumulatedTime >= task->frequency) {
-            task->update();
-            task->accumulatedTime -= task->frequency;
+    auto stageCount = size_t{0};
+    for (auto i = 0u; i < dueTasks.size(); i++) {
+        const auto& access = tasks[dueTasks[i]]->access;
+
+        // put task right after the last stage which has task conflicting with it
+        auto stage = size_t{0};
+        for (auto j = 0u; j < i; j++) {
+            if (access.conflictsWith(tasks[dueTasks[j]]->access)) {
+                stage = std::max(stage, stageOf[dueTasks[j]] + 1);
+            }
         }
 
-        if (nextTaskUpdate - timeAlreadyElapsed.elapsed() > task->frequency - task->accumulatedTime) {
-            nextTaskUpdate = task->frequency - task->accumulatedTime;
-            timeAlreadyElapsed.reset();
+        stageOf[dueTasks[i]] = stage;
+        stageCount = std::max(stageCount, stage + 1);
+        if (stages.size() < stageCount) {
+            stages.resize(stageCount);
+        }
+
+        // main thread tasks go first in the stage, see runStage
+        auto& stageTasks = stages[stage];
+        if (access.mainThread) {
+            auto firstOtherTask = std::find_if(stageTasks.begin(), stageTasks.end(),
+                                               [this](size_t id) { return !tasks[id]->access.mainThread; });
+            stageTasks.insert(firstOtherTask, dueTasks[i]);
+        } else {
+            stageTasks.push_back(dueTasks[i]);
         }
     }
 
-    return nextTaskUpdate - timeAlreadyElapsed.elapsed();
+    stages.resize(stageCount);
+}
+
+void TaskScheduler::runStage(const std::vector<size_t>& stage) {
+    auto mainThreadTasks = (size_t)std::count_if(stage.begin(), stage.end(), [this](size_t id) {
+        return id < tasks.size() && tasks[id] && tasks[id]->access.mainThread;
+    });
+
+    engine.threadPool.run(stage.size(),
+                          [&](size_t job, size_t) {
+                              auto id = stage[job];
+                              if (id < tasks.size() && tasks[id]) {
+                                  ECS_PROFILE_ZONE(tasks[id]->zoneName);
+                                  tasks[id]->update();
+                                  tasks[id]->lastUpdateTick = engine.components.tick();
+                              }
+                          },
+                          mainThreadTasks);
 }
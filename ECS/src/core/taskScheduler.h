@@ -2,6 +2,7 @@
 #include <memory>
 #include <vector>
 #include <chrono>
+#include <string>
 #include "task.h"
 
 namespace EECS {
@@ -13,6 +14,19 @@ class TaskBase;
 *  It is more flexible version of traditional game loop.
 *  It uses fixed timestep approach.
 *  Any Task can have different frequency - so, for example, physics can be 100Hz, rendering 30Hz, and ai 2Hz.
+*
+*  Tasks which are due in given update are split into stages. Stage consists of Tasks which don't conflict with each
+*  other(see Task) and run concurrently, on threads of ECS::threadPool. Stages run one after another. Task is put into
+*  the first stage after all stages with Tasks that conflict with it and have lower TaskID, so conflicting Tasks
+*  always run in TaskID order, like they would serially. Schedule depends only on Tasks' declarations, so it's
+*  deterministic. When it changes, it's logged by ECS::logger.
+*
+*  If Task is due more than once in single update, it runs again in the next round, after all stages of the previous
+*  one, but no more than Task's maxCatchUp times.
+*
+*  Time is accounted in nanoseconds, so Tasks don't drift because of rounding, even if their frequency isn't a whole
+*  amount of milliseconds. How late each update of a Task was, compared to the time it was due at, is recorded in its
+*  timing.
 */
 class TaskScheduler {
 public:
@@ -52,12 +66,36 @@ public:
     *
     *   \param elapsedTime time that has passed since last call of this method
     *
-    *   \returns amount of time when it doesn't need to be called again(interval to time when any task needs update)
+    *   \returns amount of time, counting from the moment elapsedTime was measured, when it doesn't need to be called
+    *   again(interval to time when any task needs update). If there are no Tasks, it's idleInterval.
     */
-    std::chrono::milliseconds update(std::chrono::milliseconds elapsedTime);
+    std::chrono::nanoseconds update(std::chrono::nanoseconds elapsedTime);
+
+    /** \brief returns stages of the first round of the last update which ran any Task, as lists of TaskIDs */
+    const std::vector<std::vector<size_t>>& getSchedule() const { return schedule; }
+
+    /** \brief returns schedule in human-readable form, like "[Input] -> [Movement, Echo] -> [Renderer]" */
+    std::string describeSchedule() const;
+
+    /** \brief returns timing of all Tasks in human-readable form, one line per Task, see TaskTiming */
+    std::string describeTiming() const;
+
+    /** \brief interval returned by update when there are no Tasks, so that main loop doesn't spin */
+    static constexpr std::chrono::milliseconds idleInterval{10};
 
 private:
     std::vector<std::unique_ptr<TaskBase>> tasks;
     ECS& engine;
+
+    // all of these are kept between updates, so that scheduling doesn't allocate every frame
+    std::vector<std::vector<size_t>> schedule;
+    std::vector<std::vector<size_t>> stages;
+    std::vector<size_t> stageOf;
+    std::vector<size_t> dueTasks;
+    std::vector<long long> pendingUpdates;
+
+    // splits dueTasks into stages
+    void buildStages();
+    void runStage(const std::vector<size_t>& stage);
 };
 }
@@ -0,0 +1,161 @@
+#include "threadPool.h"
+#include <algorithm>
+#include <utility>
+
+using namespace EECS;
+
+namespace {
+// set while thread executes jobs of some batch, so nested run() calls don't wait for themselves
+thread_local bool insideBatch = false;
+
+// index of worker thread in its pool
+thread_local size_t threadIndex = 0;
+}
+
+ThreadPool::ThreadPool(size_t threadCount) { resize(threadCount); }
+
+ThreadPool::~ThreadPool() { stop(); }
+
+void ThreadPool::resize(size_t threadCount) {
+    if (threadCount == 0) {
+        threadCount = std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    if (threadCount != size()) {
+        stop();
+        start(threadCount);
+    }
+}
+
+void ThreadPool::run(size_t jobCount, const Job& job, size_t callerJobs) {
+    if (jobCount == 0) {
+        return;
+    }
+
+    std::unique_lock<std::mutex> runLock(runMutex, std::defer_lock);
+    if (workers.empty() || jobCount == 1 || insideBatch || !runLock.try_lock()) {
+        for (auto i = 0u; i < jobCount; i++) {
+            job(i, 0);
+        }
+        return;
+    }
+
+    // jobs reserved for calling thread go to the front of its queue, the rest is split evenly
+    callerJobs = std::min(callerJobs, jobCount);
+    auto sharedJobs = jobCount - callerJobs;
+    for (auto i = 0u; i < queues.size(); i++) {
+        std::lock_guard<std::mutex> guard(queues[i]->mutex);
+        queues[i]->begin = i == 0 ? 0 : callerJobs + sharedJobs * i / queues.size();
+        queues[i]->stealableBegin = i == 0 ? callerJobs : queues[i]->begin;
+        queues[i]->end = callerJobs + sharedJobs * (i + 1) / queues.size();
+    }
+
+    {
+        std::lock_guard<std::mutex> guard(mutex);
+        currentJob = &job;
+        workersBusy = workers.size();
+        error = nullptr;
+        batch++;
+    }
+    batchStarted.notify_all();
+
+    work(0);
+
+    std::unique_lock<std::mutex> lock(mutex);
+    batchFinished.wait(lock, [this] { return workersBusy == 0; });
+    currentJob = nullptr;
+
+    if (error) {
+        std::rethrow_exception(std::exchange(error, nullptr));
+    }
+}
+
+void ThreadPool::start(size_t threadCount) {
+    stopping = false;
+    for (auto i = 0u; i < threadCount; i++) {
+        queues.push_back(std::make_unique<Queue>());
+    }
+
+    // thread 0 is the one which calls run()
+    for (auto i = 1u; i < threadCount; i++) {
+        workers.emplace_back(&ThreadPool::workerLoop, this, i, batch);
+    }
+}
+
+void ThreadPool::stop() {
+    {
+        std::lock_guard<std::mutex> guard(mutex);
+        stopping = true;
+    }
+    batchStarted.notify_all();
+
+    for (auto& worker : workers) {
+        worker.join();
+    }
+
+    workers.clear();
+    queues.clear();
+}
+
+size_t ThreadPool::currentThread() { return threadIndex; }
+
+void ThreadPool::workerLoop(size_t thread, size_t lastBatch) {
+    threadIndex = thread;
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            batchStarted.wait(lock, [&] { return stopping || batch != lastBatch; });
+            if (stopping) {
+                return;
+            }
+            lastBatch = batch;
+        }
+
+        work(thread);
+
+        std::lock_guard<std::mutex> guard(mutex);
+        if (--workersBusy == 0) {
+            batchFinished.notify_one();
+        }
+    }
+}
+
+void ThreadPool::work(size_t thread) {
+    insideBatch = true;
+
+    auto job = size_t{0};
+    while (take(thread, job) || steal(thread, job)) {
+        try {
+            (*currentJob)(job, thread);
+        } catch (...) {
+            std::lock_guard<std::mutex> guard(mutex);
+            error = std::current_exception();
+        }
+    }
+
+    insideBatch = false;
+}
+
+bool ThreadPool::take(size_t thread, size_t& job) {
+    auto& queue = *queues[thread];
+    std::lock_guard<std::mutex> guard(queue.mutex);
+    if (queue.begin == queue.end) {
+        return false;
+    }
+
+    job = queue.begin++;
+    return true;
+}
+
+bool ThreadPool::steal(size_t thread, size_t& job) {
+    for (auto i = 1u; i < queues.size(); i++) {
+        auto& victim = *queues[(thread + i) % queues.size()];
+        std::lock_guard<std::mutex> guard(victim.mutex);
+        if (std::max(victim.begin, victim.stealableBegin) < victim.end) {
+            job = --victim.end;
+            return true;
+        }
+    }
+
+    return false;
+}
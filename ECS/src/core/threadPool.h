@@ -0,0 +1,86 @@
+#pragma once
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace EECS {
+
+/** \brief set of persistent worker threads which execute batches of jobs
+*
+* Threads are created once and sleep between batches, so starting a batch is cheap compared to spawning threads.
+* Jobs of a batch are split evenly between threads at start. Thread which runs out of its own jobs steals from
+* others, so uneven jobs don't leave threads idle.
+*
+* Batch can't be started from inside of a job of another batch, or while other thread is running one - in such case
+* jobs are executed serially on the calling thread.
+*/
+class ThreadPool {
+public:
+    using Job = std::function<void(size_t job, size_t thread)>;
+
+    // threadCount is amount of threads which execute jobs, including the one which calls run(). 0 means one per
+    // hardware thread.
+    explicit ThreadPool(size_t threadCount = 0);
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+    ~ThreadPool();
+
+    // restarts pool with given amount of threads, see constructor. Must not be called while batch is running.
+    void resize(size_t threadCount);
+
+    // amount of threads which execute jobs, including the one which calls run().
+    size_t size() const { return queues.size(); }
+
+    // calls job(index, thread) for every index in [0, jobCount) and returns once all of them are done. thread is in
+    // [0, size()) and identifies the thread which executes the call, so jobs can write to per-thread storage without
+    // locking. First callerJobs jobs are executed by the calling thread(thread 0), others can be executed by any
+    // thread. If any job throws, one of exceptions is rethrown here after the batch finishes.
+    void run(size_t jobCount, const Job& job, size_t callerJobs = 0);
+
+    // index of the calling thread in the pool it belongs to, in [0, size()). 0 for threads which don't belong to any
+    // pool, like the one which calls run(). Unlike thread argument of jobs, it doesn't change when nested batch is
+    // executed serially.
+    static size_t currentThread();
+
+private:
+    // range of job indices which are yet to be taken. Owner takes from the front, thieves from the back, but only
+    // jobs from stealableBegin onwards.
+    struct Queue {
+        std::mutex mutex;
+        size_t begin = 0;
+        size_t stealableBegin = 0;
+        size_t end = 0;
+    };
+
+    std::vector<std::thread> workers;
+    std::vector<std::unique_ptr<Queue>> queues;
+
+    std::mutex mutex;
+    std::condition_variable batchStarted;
+    std::condition_variable batchFinished;
+    const Job* currentJob = nullptr;
+    size_t batch = 0;
+    size_t workersBusy = 0;
+    bool stopping = false;
+    std::exception_ptr error;
+
+    // taken by run(), so only one batch is running at a time
+    std::mutex runMutex;
+
+    void start(size_t threadCount);
+    void stop();
+
+    // lastBatch is the batch which was already finished when thread was started
+    void workerLoop(size_t thread, size_t lastBatch);
+
+    // executes jobs until there are none left in any queue
+    void work(size_t thread);
+
+    bool take(size_t thread, size_t& job);
+    bool steal(size_t thread, size_t& job);
+};
+}
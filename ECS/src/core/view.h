@@ -0,0 +1,383 @@
+#pragma once
+#include <algorithm>
+#include <cstddef>
+#include <iterator>
+#include <limits>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include "componentContainer.h"
+#include "archetypeStorage.h"
+#include "componentContainerID.h"
+
+namespace EECS {
+
+// View parameters which give access to component T, but visit only entities whose T was accessed for modification,
+// or added, after tick passed to view(). Adding component counts as modifying it. Can be combined with const:
+//
+// for (auto [entity, position] : ecs.components.view<Changed<const PositionComponent>>(lastUpdateTick)) {...}
+template <typename T>
+struct Changed {};
+
+template <typename T>
+struct Added {};
+
+// describes single parameter of View or Group - which component it gives access to, and how.
+template <typename T>
+struct QueryTerm {
+    using Component = std::remove_const_t<T>;
+    using Reference = T&;
+
+    // components accessed through non-const reference are stamped as changed
+    static constexpr bool mutableAccess = !std::is_const_v<T>;
+    static constexpr bool filtered = false;
+
+    static bool matches(const Component&, Tick) { return true; }
+};
+
+template <typename T>
+struct QueryTerm<Changed<T>> : QueryTerm<T> {
+    static constexpr bool filtered = true;
+
+    static bool matches(const typename QueryTerm<T>::Component& component, Tick since) {
+        return component.changedTick > since;
+    }
+};
+
+template <typename T>
+struct QueryTerm<Added<T>> : QueryTerm<T> {
+    static constexpr bool filtered = true;
+
+    static bool matches(const typename QueryTerm<T>::Component& component, Tick since) {
+        return component.addedTick > since;
+    }
+};
+
+template <typename T>
+using ComponentOf = typename QueryTerm<T>::Component;
+
+// returns component accessed through View or Group parameter, stamped as changed unless it was requested as const
+template <typename T>
+typename QueryTerm<T>::Reference access(ComponentOf<T>& component, Tick tick) {
+    if constexpr (QueryTerm<T>::mutableAccess) {
+        component.changedTick = tick;
+    }
+    return component;
+}
+
+/** \brief lazy range of all entities which have *at least* given component types
+*
+* Obtained by ComponentManager::view<A, B, C>(). Doesn't allocate anything, matching entities are found while
+* iterating. Each element is std::tuple<EntityID, A&, B&, C&>, so it's convenient to use with structured bindings:
+*
+* for (auto [entity, position, movement] : ecs.components.view<PositionComponent, MovementComponent>()) {
+*     position.position += movement.velocity;
+* }
+*
+* Components requested as non-const are stamped as changed when iterator is dereferenced, so read-only queries should
+* request const types. Changed<T> and Added<T> skip entities whose T didn't change since tick passed to view().
+*
+* Iteration is driven by the smallest container among requested types, and remaining types are looked up per entity.
+* If all types are Archetype-stored, View walks chunks of matching archetypes instead, without any lookups.
+*
+* View can be also split into parts of roughly the same memory footprint with part(), so that they can be processed in
+* parallel - see ComponentManager::parallelForEach.
+*
+* Components of requested types must not be added or deleted while iterating, as this relocates components.
+*/
+template <typename... ComponentTypes>
+class View {
+    static_assert(sizeof...(ComponentTypes) > 0, "View needs at least one component type");
+
+    static constexpr bool chunked = ((storageOf<ComponentOf<ComponentTypes>>() == ComponentStorage::Archetype) && ...);
+    static constexpr bool filtered = (QueryTerm<ComponentTypes>::filtered || ...);
+    using Indices = std::index_sequence_for<ComponentTypes...>;
+
+public:
+    using value_type = std::tuple<EntityID, typename QueryTerm<ComponentTypes>::Reference...>;
+
+    class Iterator {
+    public:
+        using value_type = View::value_type;
+        using difference_type = std::ptrdiff_t;
+
+        Iterator() = default;
+
+        value_type operator*() const { return dereference(Indices{}); }
+
+        Iterator& operator++() {
+            advance();
+            return *this;
+        }
+
+        void operator++(int) { ++*this; }
+
+        bool operator==(std::default_sentinel_t) const { return atEnd(); }
+
+    private:
+        const View* view = nullptr;
+        EntityID entity = 0;
+        std::tuple<ComponentOf<ComponentTypes>*...> current;
+
+        // driving container position. When chunked, row within current chunk.
+        size_t index = 0;
+        size_t end = 0;
+
+        // used only when chunked
+        size_t archetype = 0;
+        size_t chunk = 0;
+        size_t chunkEntities = 0;
+        const EntityID* entities = nullptr;
+        std::tuple<ComponentOf<ComponentTypes>*...> columns;
+        bool singleChunk = false;
+
+        // iterates over whole view
+        explicit Iterator(const View& view) : view(&view) {
+            // both start just before the first element, so that overflowing increment moves to it
+            if constexpr (chunked) {
+                archetype = std::numeric_limits<size_t>::max();
+                nextChunk();
+                skipFiltered();
+            } else {
+                index = std::numeric_limits<size_t>::max();
+                end = view.driverSize;
+                advance();
+            }
+        }
+
+        // iterates over single part - positions [first, second) of driving container, or when chunked, chunk 'second'
+        // of archetype 'first'
+        Iterator(const View& view, size_t first, size_t second) : view(&view) {
+            if constexpr (chunked) {
+                archetype = first;
+                chunk = second;
+                singleChunk = true;
+                if (archetype < view.archetypes->getArchetypes().size()) {
+                    setChunk(view.archetypes->getArchetypes()[archetype]);
+                    skipFiltered();
+                }
+            } else {
+                index = first - 1;
+                end = second;
+                advance();
+            }
+        }
+
+        template <size_t... I>
+        value_type dereference(std::index_sequence<I...>) const {
+            auto tick = std::get<0>(view->containers)->currentTick();
+            if constexpr (chunked) {
+                return value_type{entities[index], access<ComponentTypes>(std::get<I>(columns)[index], tick)...};
+            } else {
+                return value_type{entity, access<ComponentTypes>(*std::get<I>(current), tick)...};
+            }
+        }
+
+        bool atEnd() const {
+            if constexpr (chunked) {
+                return archetype >= view->archetypes->getArchetypes().size();
+            } else {
+                return index >= end;
+            }
+        }
+
+        void advance() {
+            if constexpr (chunked) {
+                nextRow();
+                skipFiltered();
+            } else {
+                while (++index < end && !view->fill(index, entity, current, Indices{})) {
+                }
+            }
+        }
+
+        void nextRow() {
+            if (++index >= chunkEntities) {
+                if (singleChunk) {
+                    archetype = view->archetypes->getArchetypes().size();
+                } else {
+                    nextChunk();
+                }
+            }
+        }
+
+        // moves to the first row, starting from the current one, which passes Changed and Added filters
+        void skipFiltered() {
+            if constexpr (filtered) {
+                while (!atEnd() && !view->passes(columns, index, Indices{})) {
+                    nextRow();
+                }
+            }
+        }
+
+        // moves to the beginning of next chunk of current archetype, or first chunk of next matching archetype
+        void nextChunk() {
+            const auto& archetypes = view->archetypes->getArchetypes();
+            index = 0;
+
+            if (archetype < archetypes.size() && ++chunk < archetypes[archetype].chunkCount()) {
+                setChunk(archetypes[archetype]);
+                return;
+            }
+
+            while (++archetype < archetypes.size()) {
+                if (archetypes[archetype].size() > 0 && View::matches(archetypes[archetype])) {
+                    chunk = 0;
+                    setChunk(archetypes[archetype]);
+                    return;
+                }
+            }
+        }
+
+        void setChunk(const Archetype& matching) {
+            entities = matching.entities(chunk);
+            chunkEntities = matching.chunkSizeOf(chunk);
+            setColumns(matching, Indices{});
+        }
+
+        template <size_t... I>
+        void setColumns(const Archetype& archetype, std::index_sequence<I...>) {
+            ((std::get<I>(columns) = (ComponentOf<ComponentTypes>*)archetype.column(
+                  chunk, archetype.columnOf(ComponentContainerID::get<ComponentOf<ComponentTypes>>()))),
+             ...);
+        }
+
+        friend class View;
+    };
+
+    View(ComponentContainer<ComponentOf<ComponentTypes>>&... containers, ArchetypeStorage& archetypes, Tick since = 0)
+        : containers(&containers...), archetypes(&archetypes), since(since) {
+        if constexpr (!chunked) {
+            chooseDriver(Indices{});
+        }
+    }
+
+    // range over some part of the view
+    class Part {
+    public:
+        Iterator begin() const { return first; }
+        std::default_sentinel_t end() const { return {}; }
+
+    private:
+        Iterator first;
+
+        explicit Part(Iterator first) : first(first) {}
+        friend class View;
+    };
+
+    Iterator begin() const { return Iterator(*this); }
+    std::default_sentinel_t end() const { return {}; }
+
+    // amount of parts view is split into by part(). Each of them covers about Archetype::chunkSize bytes of the
+    // driving container, or single chunk of archetype.
+    size_t partCount() const {
+        if constexpr (chunked) {
+            auto count = size_t{0};
+            for (const auto& archetype : archetypes->getArchetypes()) {
+                if (matches(archetype)) {
+                    count += archetype.chunkCount();
+                }
+            }
+            return count;
+        } else {
+            return (driverSize + entitiesPerPart() - 1) / entitiesPerPart();
+        }
+    }
+
+    // range over index-th part of the view, index must be lower than partCount(). Together, parts cover the whole view
+    // and don't overlap.
+    Part part(size_t index) const {
+        if constexpr (chunked) {
+            const auto& all = archetypes->getArchetypes();
+            for (auto i = 0u; i < all.size(); i++) {
+                if (matches(all[i])) {
+                    if (index < all[i].chunkCount()) {
+                        return Part(Iterator(*this, i, index));
+                    }
+                    index -= all[i].chunkCount();
+                }
+            }
+            return Part(Iterator(*this, all.size(), 0));
+        } else {
+            auto begin = index * entitiesPerPart();
+            return Part(Iterator(*this, begin, std::min(begin + entitiesPerPart(), driverSize)));
+        }
+    }
+
+    // upper bound of amount of entities in this view
+    size_t sizeHint() const {
+        if constexpr (chunked) {
+            return std::min({archetypes->count(ComponentContainerID::get<ComponentOf<ComponentTypes>>())...});
+        } else {
+            return driverSize;
+        }
+    }
+
+private:
+    std::tuple<ComponentContainer<ComponentOf<ComponentTypes>>*...> containers;
+    ArchetypeStorage* archetypes;
+    Tick since = 0;
+
+    // container which drives iteration - its index in ComponentTypes, and layout of its components
+    size_t driver = 0;
+    size_t driverSize = 0;
+    const std::byte* driverEntityIDs = nullptr;
+    size_t driverStride = 0;
+
+    size_t entitiesPerPart() const { return std::max(size_t{1}, Archetype::chunkSize / driverStride); }
+
+    static bool matches(const Archetype& archetype) {
+        return ((archetype.columnOf(ComponentContainerID::get<ComponentOf<ComponentTypes>>()) >= 0) && ...);
+    }
+
+    template <size_t... I>
+    bool passes(const std::tuple<ComponentOf<ComponentTypes>*...>& components, size_t row,
+                std::index_sequence<I...>) const {
+        return (QueryTerm<ComponentTypes>::matches(std::get<I>(components)[row], since) && ...);
+    }
+
+    // picks the smallest container which keeps components contiguously
+    template <size_t... I>
+    void chooseDriver(std::index_sequence<I...>) {
+        driverSize = std::numeric_limits<size_t>::max();
+        (considerDriver<I>(), ...);
+    }
+
+    template <size_t I>
+    void considerDriver() {
+        using T = ComponentOf<std::tuple_element_t<I, std::tuple<ComponentTypes...>>>;
+        if constexpr (storageOf<T>() != ComponentStorage::Archetype) {
+            auto& components = std::get<I>(containers)->getAllComponents();
+            if (components.size() < driverSize) {
+                driver = I;
+                driverSize = components.size();
+                driverEntityIDs = components.empty() ? nullptr : (const std::byte*)&components.front().entityID;
+                driverStride = sizeof(T);
+            }
+        }
+    }
+
+    // fills pointers to components of entity at given position of driving container. Returns false if it doesn't
+    // have all of them.
+    template <size_t... I>
+    bool fill(size_t position, EntityID& entity, std::tuple<ComponentOf<ComponentTypes>*...>& components,
+              std::index_sequence<I...>) const {
+        entity = *(const EntityID*)(driverEntityIDs + position * driverStride);
+        return (fillOne<I>(position, entity, std::get<I>(components)) && ...);
+    }
+
+    template <size_t I, class T>
+    bool fillOne(size_t position, EntityID entity, T*& component) const {
+        using Term = QueryTerm<std::tuple_element_t<I, std::tuple<ComponentTypes...>>>;
+        if constexpr (storageOf<T>() != ComponentStorage::Archetype) {
+            if (driver == I) {
+                component = &std::get<I>(containers)->getAllComponents()[position];
+                return Term::matches(*component, since);
+            }
+        }
+
+        component = std::get<I>(containers)->getComponent(entity);
+        return component != nullptr && Term::matches(*component, since);
+    }
+};
+}
@@ -0,0 +1,104 @@
+#include "profiler.h"
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+
+using namespace EECS;
+
+namespace {
+// samples of the calling thread, registered in Profiler on first record()
+thread_local void* threadSamples = nullptr;
+
+void writeEscaped(std::ostream& output, const char* text) {
+    for (; *text; text++) {
+        if (*text == '"' || *text == '\\') {
+            output << '\\';
+        }
+        output << *text;
+    }
+}
+}
+
+Profiler& Profiler::get() {
+    static Profiler profiler;
+    return profiler;
+}
+
+void Profiler::record(const char* name, Clock::time_point start, Clock::time_point end) {
+    auto& thread = local();
+    thread.ring[thread.written % thread.ring.size()] = {
+        name, std::chrono::duration_cast<std::chrono::nanoseconds>(start - epoch).count(),
+        std::chrono::duration_cast<std::chrono::nanoseconds>(end - epoch).count()};
+    thread.written++;
+}
+
+void Profiler::setCapacity(size_t capacity) {
+    std::lock_guard<std::mutex> guard(mutex);
+    this->capacity = std::max<size_t>(capacity, 1);
+}
+
+void Profiler::clear() {
+    std::lock_guard<std::mutex> guard(mutex);
+    for (auto& thread : threads) {
+        thread->ring.assign(capacity, {});
+        thread->written = 0;
+    }
+}
+
+std::vector<ProfileSample> Profiler::samples() const {
+    std::lock_guard<std::mutex> guard(mutex);
+    std::vector<ProfileSample> samples;
+    for (const auto& thread : threads) {
+        forEachSample(*thread, [&](const ProfileSample& sample) { samples.push_back(sample); });
+    }
+    return samples;
+}
+
+void Profiler::exportChromeTrace(std::ostream& output) const {
+    std::lock_guard<std::mutex> guard(mutex);
+
+    // complete events, with times in microseconds
+    output << "{\"traceEvents\":[" << std::fixed << std::setprecision(3);
+    auto first = true;
+    for (const auto& thread : threads) {
+        forEachSample(*thread, [&](const ProfileSample& sample) {
+            output << (first ? "\n" : ",\n") << "{\"name\":\"";
+            writeEscaped(output, sample.name);
+            output << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << thread->thread << ",\"ts\":" << sample.start / 1000.0
+                   << ",\"dur\":" << (sample.end - sample.start) / 1000.0 << "}";
+            first = false;
+        });
+    }
+    output << "\n],\"displayTimeUnit\":\"ns\"}\n";
+}
+
+bool Profiler::exportChromeTrace(const std::string& filename) const {
+    std::ofstream file(filename);
+    if (!file) {
+        return false;
+    }
+
+    exportChromeTrace(file);
+    return (bool)file;
+}
+
+Profiler::ThreadSamples& Profiler::local() {
+    if (threadSamples == nullptr) {
+        std::lock_guard<std::mutex> guard(mutex);
+        auto thread = std::make_unique<ThreadSamples>();
+        thread->thread = threads.size();
+        thread->ring.resize(capacity);
+        threadSamples = thread.get();
+        threads.push_back(std::move(thread));
+    }
+
+    return *static_cast<ThreadSamples*>(threadSamples);
+}
+
+template <typename Function>
+void Profiler::forEachSample(const ThreadSamples& thread, Function&& function) const {
+    auto kept = std::min(thread.written, thread.ring.size());
+    for (auto i = thread.written - kept; i < thread.written; i++) {
+        function(thread.ring[i % thread.ring.size()]);
+    }
+}
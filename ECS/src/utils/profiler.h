@@ -0,0 +1,96 @@
+#pragma once
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace EECS {
+
+// time span of a single zone, in nanoseconds since Profiler was created
+struct ProfileSample {
+    const char* name;
+    int64_t start;
+    int64_t end;
+};
+
+/** \brief records how long zones of code take, on every thread
+*
+* Zones are marked with ECS_PROFILE_ZONE("name"), which records a sample when the scope it's in ends. ECS marks
+* TaskScheduler::update and each Task's update, EventQueue::emit and parallel ComponentManager queries.
+*
+* Every thread writes samples to its own ring buffer, so recording doesn't lock, and only the latest samples are
+* kept. They can be exported as Chrome trace events, which can be viewed in Perfetto(ui.perfetto.dev) or
+* chrome://tracing. ECS::run exports them to profiler.traceFile when it ends.
+*
+* Zones are compiled only if ECS_PROFILING is defined, otherwise ECS_PROFILE_ZONE expands to nothing. None of the
+* project configurations defines it - to profile, add ECS_PROFILING to Preprocessor Definitions(C/C++ -> Preprocessor)
+* of ECS and of the game, in the same configuration, as zones are expanded in headers too. Names of zones must live
+* as long as Profiler, like string literals.
+*/
+class Profiler {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    static Profiler& get();
+
+    void record(const char* name, Clock::time_point start, Clock::time_point end);
+
+    // amount of samples kept per thread. Applies to threads which record their first sample after the call, and to
+    // all threads after clear().
+    void setCapacity(size_t capacity);
+
+    // discards all samples. Must not be called while zones are recorded.
+    void clear();
+
+    // samples of all threads, oldest first, thread after thread
+    std::vector<ProfileSample> samples() const;
+
+    // writes samples in Chrome trace event format. Must not be called while zones are recorded.
+    void exportChromeTrace(std::ostream& output) const;
+    bool exportChromeTrace(const std::string& filename) const;
+
+private:
+    struct ThreadSamples {
+        size_t thread;
+        std::vector<ProfileSample> ring;
+        size_t written = 0;
+    };
+
+    Clock::time_point epoch = Clock::now();
+    size_t capacity = 1 << 16;
+
+    mutable std::mutex mutex;
+    std::vector<std::unique_ptr<ThreadSamples>> threads;
+
+    ThreadSamples& local();
+
+    template <typename Function>
+    void forEachSample(const ThreadSamples& thread, Function&& function) const;
+};
+
+// records sample of Profiler for its lifetime, see ECS_PROFILE_ZONE
+class ProfileZone {
+public:
+    explicit ProfileZone(const char* name) : profiler(Profiler::get()), name(name), start(Profiler::Clock::now()) {}
+    ProfileZone(const ProfileZone&) = delete;
+    ProfileZone& operator=(const ProfileZone&) = delete;
+    ~ProfileZone() { profiler.record(name, start, Profiler::Clock::now()); }
+
+private:
+    Profiler& profiler;
+    const char* name;
+    Profiler::Clock::time_point start;
+};
+}
+
+#define ECS_PROFILE_CONCAT_IMPL(a, b) a##b
+#define ECS_PROFILE_CONCAT(a, b) ECS_PROFILE_CONCAT_IMPL(a, b)
+
+#if defined(ECS_PROFILING)
+#define ECS_PROFILE_ZONE(name) ::EECS::ProfileZone ECS_PROFILE_CONCAT(profileZone, __LINE__)(name)
+#else
+#define ECS_PROFILE_ZONE(name) ((void)0)
+#endif
@@ -0,0 +1,59 @@
+#pragma once
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace EECS {
+
+/** \brief stable sort of elements by unsigned integer key, in linear time
+*
+* Least significant digit radix sort - elements are distributed by one byte of the key at a time, starting from the
+* lowest one. Pass is skipped if all elements have the same value of its byte, so sorting by small keys(or keys which
+* differ only in a few bytes) costs only a few passes over elements. Faster than comparison sorts for many elements
+* with narrow keys, like sprites ordered by plane.
+*
+* scratch is used as second buffer, pass the same one between calls to avoid allocating it again:
+*
+* radixSort(sprites, scratch, [](const Sprite& sprite) { return sprite.key; });
+*/
+template <typename T, typename KeyFunction>
+void radixSort(std::vector<T>& elements, std::vector<T>& scratch, KeyFunction&& key) {
+    using Key = decltype(key(elements.front()));
+    static_assert(std::is_unsigned_v<Key>, "Key has to be unsigned integer");
+    if (elements.size() < 2) {
+        return;
+    }
+
+    // histograms of all bytes are counted at once, so elements are read only once before passes
+    std::array<std::array<size_t, 256>, sizeof(Key)> counts{};
+    for (const auto& element : elements) {
+        auto value = key(element);
+        for (auto byte = 0u; byte < sizeof(Key); byte++) {
+            counts[byte][(value >> (byte * 8)) & 0xFF]++;
+        }
+    }
+
+    scratch.resize(elements.size());
+    for (auto byte = 0u; byte < sizeof(Key); byte++) {
+        auto& count = counts[byte];
+        auto first = (key(elements.front()) >> (byte * 8)) & 0xFF;
+        if (count[first] == elements.size()) {
+            continue;
+        }
+
+        // offsets of buckets
+        auto offset = size_t{0};
+        for (auto& bucket : count) {
+            offset += std::exchange(bucket, offset);
+        }
+
+        for (auto& element : elements) {
+            scratch[count[(key(element) >> (byte * 8)) & 0xFF]++] = std::move(element);
+        }
+        elements.swap(scratch);
+    }
+}
+}
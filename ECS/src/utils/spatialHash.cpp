@@ -0,0 +1,208 @@
+#include "spatialHash.h"
+#include <algorithm>
+
+#if defined(__AVX__)
+#include <immintrin.h>
+#elif defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#define SPATIAL_HASH_SSE
+#include <xmmintrin.h>
+#endif
+
+using namespace EECS;
+
+void SpatialHash::setCellSize(float size) {
+    if (size <= 0.f || size == cellSize) {
+        return;
+    }
+
+    cellSize = size;
+    cells.clear();
+    for (auto& body : bodies) {
+        body.cells = cellsOf(body.box);
+        insertIntoCells(body);
+    }
+}
+
+void SpatialHash::update(EntityID entity, const Box& box, bool isStatic) {
+    auto slot = slots.get(entity);
+
+    // body of deleted entity whose index was reused
+    if (slot != SparseIndex::npos && bodies[slot].entity != entity) {
+        remove(bodies[slot].entity);
+        slot = SparseIndex::npos;
+    }
+
+    if (slot == SparseIndex::npos) {
+        slots.set(entity, (uint32_t)bodies.size());
+        bodies.push_back({entity, box, cellsOf(box), isStatic, frame});
+        insertIntoCells(bodies.back());
+        return;
+    }
+
+    auto& body = bodies[slot];
+    body.lastFrame = frame;
+
+    auto range = cellsOf(box);
+    if (!(range == body.cells) || isStatic != body.isStatic) {
+        removeFromCells(body);
+        body.box = box;
+        body.cells = range;
+        body.isStatic = isStatic;
+        insertIntoCells(body);
+        return;
+    }
+
+    // boxes of moving bodies aren't kept in cells
+    auto moved = box.left != body.box.left || box.top != body.box.top || box.right != body.box.right ||
+                 box.bottom != body.box.bottom;
+    body.box = box;
+    if (isStatic && moved) {
+        for (auto x = range.minX; x <= range.maxX; x++) {
+            for (auto y = range.minY; y <= range.maxY; y++) {
+                cells[cellKey(x, y)].setBox(entity, box);
+            }
+        }
+    }
+}
+
+bool SpatialHash::remove(EntityID entity) {
+    auto slot = slots.get(entity);
+    if (slot == SparseIndex::npos || bodies[slot].entity != entity) {
+        return false;
+    }
+
+    removeFromCells(bodies[slot]);
+
+    // fill the hole with the last body
+    if (slot != bodies.size() - 1) {
+        bodies[slot] = bodies.back();
+        slots.set(bodies[slot].entity, slot);
+    }
+    bodies.pop_back();
+    slots.reset(entity);
+    return true;
+}
+
+void SpatialHash::removeStale() {
+    for (auto i = bodies.size(); i > 0; i--) {
+        if (bodies[i - 1].lastFrame != frame) {
+            remove(bodies[i - 1].entity);
+        }
+    }
+
+    frame++;
+}
+
+void SpatialHash::clear() {
+    for (const auto& body : bodies) {
+        slots.reset(body.entity);
+    }
+    bodies.clear();
+    cells.clear();
+}
+
+uint32_t SpatialHash::overlapMask(const Box& box, const Cell& cell, size_t first) {
+    auto count = std::min(batchSize, cell.staticBodies.size() - first);
+    auto mask = uint32_t{0};
+    auto i = size_t{0};
+
+#if defined(__AVX__)
+    if (count == 8) {
+        auto overlaps = _mm256_and_ps(
+            _mm256_and_ps(_mm256_cmp_ps(_mm256_set1_ps(box.left), _mm256_loadu_ps(&cell.right[first]), _CMP_LT_OQ),
+                          _mm256_cmp_ps(_mm256_loadu_ps(&cell.left[first]), _mm256_set1_ps(box.right), _CMP_LT_OQ)),
+            _mm256_and_ps(_mm256_cmp_ps(_mm256_set1_ps(box.top), _mm256_loadu_ps(&cell.bottom[first]), _CMP_LT_OQ),
+                          _mm256_cmp_ps(_mm256_loadu_ps(&cell.top[first]), _mm256_set1_ps(box.bottom), _CMP_LT_OQ)));
+        return (uint32_t)_mm256_movemask_ps(overlaps);
+    }
+#elif defined(SPATIAL_HASH_SSE)
+    for (; i + 4 <= count; i += 4) {
+        auto at = first + i;
+        auto overlaps = _mm_and_ps(
+            _mm_and_ps(_mm_cmplt_ps(_mm_set1_ps(box.left), _mm_loadu_ps(&cell.right[at])),
+                       _mm_cmplt_ps(_mm_loadu_ps(&cell.left[at]), _mm_set1_ps(box.right))),
+            _mm_and_ps(_mm_cmplt_ps(_mm_set1_ps(box.top), _mm_loadu_ps(&cell.bottom[at])),
+                       _mm_cmplt_ps(_mm_loadu_ps(&cell.top[at]), _mm_set1_ps(box.bottom))));
+        mask |= (uint32_t)_mm_movemask_ps(overlaps) << i;
+    }
+#endif
+
+    // rest of the batch which doesn't fill whole register
+    for (; i < count; i++) {
+        auto at = first + i;
+        if (box.left < cell.right[at] && cell.left[at] < box.right && box.top < cell.bottom[at] &&
+            cell.top[at] < box.bottom) {
+            mask |= 1u << i;
+        }
+    }
+
+    return mask;
+}
+
+void SpatialHash::insertIntoCells(const Body& body) {
+    for (auto x = body.cells.minX; x <= body.cells.maxX; x++) {
+        for (auto y = body.cells.minY; y <= body.cells.maxY; y++) {
+            cells[cellKey(x, y)].add(body.entity, body.box, body.isStatic);
+        }
+    }
+}
+
+void SpatialHash::removeFromCells(const Body& body) {
+    for (auto x = body.cells.minX; x <= body.cells.maxX; x++) {
+        for (auto y = body.cells.minY; y <= body.cells.maxY; y++) {
+            auto cell = cells.find(cellKey(x, y));
+            if (cell == cells.end()) {
+                continue;
+            }
+
+            // empty cells are dropped, so that bodies moving through the world don't leave a trail of them
+            cell->second.remove(body.entity, body.isStatic);
+            if (cell->second.bodies.empty() && cell->second.staticBodies.empty()) {
+                cells.erase(cell);
+            }
+        }
+    }
+}
+
+void SpatialHash::Cell::add(EntityID entity, const Box& box, bool isStatic) {
+    if (!isStatic) {
+        bodies.push_back(entity);
+        return;
+    }
+
+    staticBodies.push_back(entity);
+    left.push_back(box.left);
+    top.push_back(box.top);
+    right.push_back(box.right);
+    bottom.push_back(box.bottom);
+}
+
+void SpatialHash::Cell::remove(EntityID entity, bool isStatic) {
+    auto& entities = isStatic ? staticBodies : bodies;
+    auto position = std::find(entities.begin(), entities.end(), entity);
+    if (position == entities.end()) {
+        return;
+    }
+
+    // fill the hole with the last element
+    auto index = position - entities.begin();
+    *position = entities.back();
+    entities.pop_back();
+    if (isStatic) {
+        for (auto coordinates : {&left, &top, &right, &bottom}) {
+            (*coordinates)[index] = coordinates->back();
+            coordinates->pop_back();
+        }
+    }
+}
+
+void SpatialHash::Cell::setBox(EntityID entity, const Box& box) {
+    auto position = std::find(staticBodies.begin(), staticBodies.end(), entity);
+    if (position != staticBodies.end()) {
+        auto index = position - staticBodies.begin();
+        left[index] = box.left;
+        top[index] = box.top;
+        right[index] = box.right;
+        bottom[index] = box.bottom;
+    }
+}
@@ -0,0 +1,227 @@
+#pragma once
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+#include "../core/entityID.h"
+#include "../core/sparseIndex.h"
+
+namespace EECS {
+
+/** \brief broad phase of collision detection - finds pairs of bodies which may collide
+*
+* Space is divided into square cells of given size, and each body is kept in all cells its bounding box touches.
+* Only bodies which share a cell and whose bounding boxes overlap are reported as candidate pairs, so testing
+* n bodies costs roughly O(n) instead of O(n^2).
+*
+* Bodies are kept between frames. Body is moved to other cells only if the range of cells it touches changes, so
+* bodies which don't move(like walls) are bucketed once. Pairs of two static bodies are never reported. Moving body
+* is tested against static bodies of a cell in batches, using SIMD instructions where available.
+*
+* Sample usage, every frame:
+*
+* for (auto [entity, position, size, collision] : ...) {
+*     broadPhase.update(entity, {x, y, x + width, y + height}, collision.isStatic);
+* }
+* broadPhase.removeStale();
+* broadPhase.forEachPair([](EntityID first, EntityID second) { ...narrow phase... });
+*
+* It can also find bodies inside of given area with forEachInBox, for example to cull ones which are off-screen.
+*/
+class SpatialHash {
+public:
+    // axis-aligned bounding box
+    struct Box {
+        float left = 0.f;
+        float top = 0.f;
+        float right = 0.f;
+        float bottom = 0.f;
+
+        bool overlaps(const Box& other) const {
+            return left < other.right && other.left < right && top < other.bottom && other.top < bottom;
+        }
+    };
+
+    explicit SpatialHash(float cellSize = 1.f) : cellSize(cellSize) {}
+
+    // changes size of cells and rebuckets all bodies. Best size is about the size of typical moving body.
+    void setCellSize(float size);
+    float getCellSize() const { return cellSize; }
+
+    // adds body, or updates its bounding box if it's already there. Marks body as present in current frame.
+    void update(EntityID entity, const Box& box, bool isStatic);
+
+    // removes body, returns false if it wasn't there.
+    bool remove(EntityID entity);
+
+    // removes bodies which weren't updated since the previous call, and starts new frame.
+    void removeStale();
+
+    // removes bodies of entities for which predicate(entity) returns true.
+    template <typename Predicate>
+    void removeIf(Predicate&& predicate) {
+        for (auto i = bodies.size(); i > 0; i--) {
+            if (predicate(bodies[i - 1].entity)) {
+                remove(bodies[i - 1].entity);
+            }
+        }
+    }
+
+    void clear();
+
+    size_t size() const { return bodies.size(); }
+
+    // amount of cells which contain at least one body
+    size_t cellCount() const { return cells.size(); }
+
+    // calls function(first, second) once for every pair of bodies which share a cell, have overlapping bounding
+    // boxes and aren't both static. Non-static body is always the first one.
+    template <typename Function>
+    void forEachPair(Function&& function) const {
+        for (const auto& body : bodies) {
+            if (body.isStatic) {
+                continue;
+            }
+
+            for (auto x = body.cells.minX; x <= body.cells.maxX; x++) {
+                for (auto y = body.cells.minY; y <= body.cells.maxY; y++) {
+                    auto found = cells.find(cellKey(x, y));
+                    if (found == cells.end()) {
+                        continue;
+                    }
+                    const auto& cell = found->second;
+
+                    // static bodies are tested batchSize at a time
+                    for (auto first = size_t{0}; first < cell.staticBodies.size(); first += batchSize) {
+                        for (auto mask = overlapMask(body.box, cell, first); mask != 0; mask &= mask - 1) {
+                            const auto& other = bodies[slots.get(cell.staticBodies[first + std::countr_zero(mask)])];
+                            if (isFirstCommonCell(body.cells, other.cells, x, y)) {
+                                function(body.entity, other.entity);
+                            }
+                        }
+                    }
+
+                    // pair of two moving bodies is reported by the one with lower EntityID
+                    for (auto otherEntity : cell.bodies) {
+                        const auto& other = bodies[slots.get(otherEntity)];
+                        if (body.entity < other.entity && isFirstCommonCell(body.cells, other.cells, x, y) &&
+                            body.box.overlaps(other.box)) {
+                            function(body.entity, other.entity);
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    // calls function(entity) once for every body whose bounding box overlaps given box, static or not. Order is
+    // undefined.
+    template <typename Function>
+    void forEachInBox(const Box& box, Function&& function) const {
+        auto range = cellsOf(box);
+
+        // box covering more cells than there are bodies is cheaper to test against each of them
+        auto cellCount = ((int64_t)range.maxX - range.minX + 1) * ((int64_t)range.maxY - range.minY + 1);
+        if (cellCount > (int64_t)bodies.size()) {
+            for (const auto& body : bodies) {
+                if (body.box.overlaps(box)) {
+                    function(body.entity);
+                }
+            }
+            return;
+        }
+
+        for (auto x = range.minX; x <= range.maxX; x++) {
+            for (auto y = range.minY; y <= range.maxY; y++) {
+                auto found = cells.find(cellKey(x, y));
+                if (found == cells.end()) {
+                    continue;
+                }
+                const auto& cell = found->second;
+
+                for (auto first = size_t{0}; first < cell.staticBodies.size(); first += batchSize) {
+                    for (auto mask = overlapMask(box, cell, first); mask != 0; mask &= mask - 1) {
+                        const auto& other = bodies[slots.get(cell.staticBodies[first + std::countr_zero(mask)])];
+                        if (isFirstCommonCell(range, other.cells, x, y)) {
+                            function(other.entity);
+                        }
+                    }
+                }
+
+                for (auto otherEntity : cell.bodies) {
+                    const auto& other = bodies[slots.get(otherEntity)];
+                    if (isFirstCommonCell(range, other.cells, x, y) && box.overlaps(other.box)) {
+                        function(other.entity);
+                    }
+                }
+            }
+        }
+    }
+
+private:
+    // inclusive range of cells touched by the body
+    struct CellRange {
+        int32_t minX = 0;
+        int32_t minY = 0;
+        int32_t maxX = -1;
+        int32_t maxY = -1;
+
+        bool operator==(const CellRange& other) const {
+            return minX == other.minX && minY == other.minY && maxX == other.maxX && maxY == other.maxY;
+        }
+    };
+
+    struct Body {
+        EntityID entity;
+        Box box;
+        CellRange cells;
+        bool isStatic;
+        size_t lastFrame;
+    };
+
+    // static bodies also keep copy of their boxes in the cell, as separate arrays of coordinates, so many of them can
+    // be tested against one box at once
+    struct Cell {
+        std::vector<EntityID> bodies;
+        std::vector<EntityID> staticBodies;
+        std::vector<float> left;
+        std::vector<float> top;
+        std::vector<float> right;
+        std::vector<float> bottom;
+
+        void add(EntityID entity, const Box& box, bool isStatic);
+        void remove(EntityID entity, bool isStatic);
+        void setBox(EntityID entity, const Box& box);
+    };
+
+    // amount of static bodies tested at once by overlapMask
+    static constexpr size_t batchSize = 8;
+
+    float cellSize;
+    size_t frame = 0;
+
+    std::vector<Body> bodies;
+    SparseIndex slots;
+    std::unordered_map<uint64_t, Cell> cells;
+
+    static uint64_t cellKey(int32_t x, int32_t y) { return ((uint64_t)(uint32_t)x << 32) | (uint32_t)y; }
+
+    CellRange cellsOf(const Box& box) const {
+        return {(int32_t)std::floor(box.left / cellSize), (int32_t)std::floor(box.top / cellSize),
+                (int32_t)std::floor(box.right / cellSize), (int32_t)std::floor(box.bottom / cellSize)};
+    }
+
+    // pair is reported only from the first cell both bodies touch, so that it's reported once
+    static bool isFirstCommonCell(const CellRange& first, const CellRange& second, int32_t x, int32_t y) {
+        return x == std::max(first.minX, second.minX) && y == std::max(first.minY, second.minY);
+    }
+
+    // returns mask with bit i set if box overlaps box of static body first + i of the cell, for i < batchSize
+    static uint32_t overlapMask(const Box& box, const Cell& cell, size_t first);
+
+    void insertIntoCells(const Body& body);
+    void removeFromCells(const Body& body);
+};
+}
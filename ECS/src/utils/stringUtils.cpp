@@ -1,5 +1,10 @@
 #include "stringUtils.h"
 #include <sstream>
+#if defined(__GNUG__)
+#include <cstdlib>
+#include <memory>
+#include <cxxabi.h>
+#endif
 
 std::vector<std::string> split(const std::string& string, char delimiter) {
     std::vector<std::string> splitted;
@@ -13,3 +18,23 @@ std::vector<std::string> split(const std::string& string, char delimiter) {
     }
     return splitted;
 }
+
+std::string typeName(const std::type_info& type) {
+    std::string name = type.name();
+
+#if defined(__GNUG__)
+    auto status = 0;
+    auto demangled = std::unique_ptr<char, void (*)(void*)>(
+        abi::__cxa_demangle(type.name(), nullptr, nullptr, &status), std::free);
+    if (status == 0 && demangled) {
+        name = demangled.get();
+    }
+#endif
+
+    for (const auto& prefix : {"class ", "struct "}) {
+        if (name.rfind(prefix, 0) == 0) {
+            name.erase(0, std::string(prefix).size());
+        }
+    }
+    return name;
+}
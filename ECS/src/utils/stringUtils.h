@@ -1,6 +1,7 @@
 #pragma once
 
 #include <string>
+#include <typeinfo>
 #include <vector>
 
 /** \brief spilts string to array of strings separated by delimiter.
@@ -11,3 +12,10 @@
 * In case of two delimiters touching, empty string willn't be included in result.
 */
 std::vector<std::string> split(const std::string& string, char delimiter);
+
+/** \brief returns name of type as written in code, like "Renderer"
+*
+* typeid(...).name() is compiler-specific - mangled on GCC and Clang, prefixed with "class " on MSVC - so it can't be
+* shown to the user as it is.
+*/
+std::string typeName(const std::type_info& type);
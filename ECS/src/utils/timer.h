@@ -5,22 +5,23 @@
 class Timer {
 public:
     /** \brief default constructor that starts timer immmediately */
-    Timer() : startTime(std::chrono::high_resolution_clock::now()){};
+    Timer() : startTime(std::chrono::steady_clock::now()){};
 
     /** \brief returns elapsed time without restarting Timer. */
-    std::chrono::milliseconds elapsed() {
-        std::chrono::high_resolution_clock::time_point now = std::chrono::high_resolution_clock::now();
+    std::chrono::nanoseconds elapsed() {
+        std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
         auto elapsedTime = now - startTime;
-        return std::chrono::duration_cast<std::chrono::milliseconds>(elapsedTime);
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(elapsedTime);
     }
 
     /** \brief returns elaped time and restarts Timer that it will start counting from 0. */
-    std::chrono::milliseconds reset() {
-        std::chrono::milliseconds elapsedTime = elapsed();
-        startTime = std::chrono::high_resolution_clock::now();
-        return elapsedTime;
+    std::chrono::nanoseconds reset() {
+        std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+        auto elapsedTime = now - startTime;
+        startTime = now;
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(elapsedTime);
     }
 
 private:
-    std::chrono::high_resolution_clock::time_point startTime;
+    std::chrono::steady_clock::time_point startTime;
 };
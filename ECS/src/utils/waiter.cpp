@@ -0,0 +1,93 @@
+#include "waiter.h"
+#include <algorithm>
+#include <thread>
+
+#if defined(__linux__)
+#include <cerrno>
+#include <time.h>
+#endif
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
+using namespace EECS;
+
+namespace {
+// lets CPU know that thread is spinning, so it uses less power and doesn't slow down other hardware thread of the core
+void spinPause() {
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+    _mm_pause();
+#else
+    std::this_thread::yield();
+#endif
+}
+}
+
+void Waiter::waitUntil(Clock::time_point deadline) {
+    if (Clock::now() >= deadline) {
+        return;
+    }
+
+    switch (strategy) {
+    case WaitStrategy::Sleep:
+        sleepUntil(deadline);
+        break;
+    case WaitStrategy::Hybrid:
+        sleepUntil(deadline - spinMargin);
+        spinUntil(deadline);
+        break;
+    case WaitStrategy::BusyPoll:
+        spinUntil(deadline);
+        break;
+    }
+
+    auto latency = Clock::now() - deadline;
+    waitStats.waits++;
+    waitStats.lastLatency = latency;
+    waitStats.maxLatency = std::max(waitStats.maxLatency, waitStats.lastLatency);
+    waitStats.totalLatency += latency;
+}
+
+std::string Waiter::describeStats() const {
+    auto microseconds = [](std::chrono::nanoseconds time) {
+        return std::to_string(std::chrono::duration<double, std::micro>(time).count()) + "us";
+    };
+
+    return std::to_string(waitStats.waits) + " waits, latency mean " + microseconds(waitStats.meanLatency()) +
+           ", max " + microseconds(waitStats.maxLatency);
+}
+
+WaitStrategy Waiter::parseStrategy(const std::string& name) {
+    if (name == "sleep") {
+        return WaitStrategy::Sleep;
+    }
+    if (name == "busy") {
+        return WaitStrategy::BusyPoll;
+    }
+    return WaitStrategy::Hybrid;
+}
+
+void Waiter::sleepUntil(Clock::time_point deadline) {
+    if (Clock::now() >= deadline) {
+        return;
+    }
+
+#if defined(__linux__)
+    // steady_clock is CLOCK_MONOTONIC there. Absolute deadline doesn't drift when sleep is interrupted.
+    auto sinceEpoch = std::chrono::duration_cast<std::chrono::nanoseconds>(deadline.time_since_epoch());
+    timespec time;
+    time.tv_sec = (time_t)(sinceEpoch.count() / 1000000000);
+    time.tv_nsec = (long)(sinceEpoch.count() % 1000000000);
+    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &time, nullptr) == EINTR) {
+    }
+#else
+    std::this_thread::sleep_until(deadline);
+#endif
+}
+
+void Waiter::spinUntil(Clock::time_point deadline) {
+    while (Clock::now() < deadline) {
+        spinPause();
+    }
+}
@@ -0,0 +1,68 @@
+#pragma once
+#include <chrono>
+#include <string>
+
+namespace EECS {
+
+enum class WaitStrategy {
+    // only sleeps, saves power, but may wake up late
+    Sleep,
+    // sleeps until shortly before deadline, then spins
+    Hybrid,
+    // only spins, for threads which have a core for themselves
+    BusyPoll
+};
+
+// how late waits finished, compared to their deadlines. Only waits which started before their deadline are counted.
+struct WaitStats {
+    size_t waits = 0;
+    std::chrono::nanoseconds lastLatency{0};
+    std::chrono::nanoseconds maxLatency{0};
+    std::chrono::nanoseconds totalLatency{0};
+
+    std::chrono::nanoseconds meanLatency() const {
+        return waits > 0 ? totalLatency / (std::chrono::nanoseconds::rep)waits : std::chrono::nanoseconds(0);
+    }
+};
+
+/** \brief waits until given point in time, more precisely than std::this_thread::sleep_until
+*
+* Sleeping thread is often woken up up to a millisecond after its deadline. In Hybrid mode Waiter sleeps until
+* spinMargin before the deadline(using clock_nanosleep with absolute deadline where available), and spins for the
+* rest of the time, so it wakes up within microseconds, at cost of spinning a bit. BusyPoll mode spins all the time,
+* which is the most precise, but keeps the core busy. Sleep mode doesn't spin at all.
+*/
+class Waiter {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    explicit Waiter(WaitStrategy strategy = WaitStrategy::Hybrid,
+                    std::chrono::nanoseconds spinMargin = std::chrono::microseconds(1000))
+        : strategy(strategy), spinMargin(spinMargin) {}
+
+    // returns at deadline or right after it. Returns immediately if deadline has passed.
+    void waitUntil(Clock::time_point deadline);
+
+    void setStrategy(WaitStrategy strategy) { this->strategy = strategy; }
+    WaitStrategy getStrategy() const { return strategy; }
+
+    // how long before deadline Hybrid mode stops sleeping and starts spinning
+    void setSpinMargin(std::chrono::nanoseconds spinMargin) { this->spinMargin = spinMargin; }
+
+    const WaitStats& stats() const { return waitStats; }
+
+    // returns stats in human-readable form
+    std::string describeStats() const;
+
+    // parses "sleep", "hybrid" or "busy", anything else is Hybrid
+    static WaitStrategy parseStrategy(const std::string& name);
+
+private:
+    WaitStrategy strategy;
+    std::chrono::nanoseconds spinMargin;
+    WaitStats waitStats;
+
+    static void sleepUntil(Clock::time_point deadline);
+    static void spinUntil(Clock::time_point deadline);
+};
+}
@@ -3,10 +3,14 @@
 #include <SFML/Graphics.hpp>
 
 struct GraphicsComponent : public Component<GraphicsComponent> {
+    static constexpr ComponentStorage storage = ComponentStorage::SparseSet;
+
 	explicit GraphicsComponent(int plane = 0) : plane(plane) {}
 
 	int plane = 0;  //Planes are drawn from high to low. INT_MAX is drawn first, INT_MIN last.
                     //Drawing order within a plane is undefined.
                     
     std::shared_ptr<sf::Texture> texture = nullptr; //for sprite
+    sf::IntRect textureRect;    //part of the texture used by sprite, in pixels. Whole texture if it's empty,
+                                //set it for textures shared by many images, like atlases
 };
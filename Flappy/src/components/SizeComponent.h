@@ -3,6 +3,8 @@
 #include <SFML/System.hpp>
 
 struct SizeComponent : public Component<SizeComponent> {
+    static constexpr ComponentStorage storage = ComponentStorage::SparseSet;
+
 	explicit SizeComponent(float width = 0, float height = 0) : width(width), height(height) { }
 
     //dimmensions of the object in world's coordinate space(the same as positions, for example)
@@ -30,12 +30,11 @@ void PlayState::cleanup() {
     scoreCounter.deleteEntity();
     score = 0;
 
-    for (auto&& hole : holes)
-        ecs.entities.deleteEntity(hole);
+    ecs.entities.destroyBatch(holes);
     holes.clear();
 
-    for (auto&& pipe : pipes)
-        ecs.entities.deleteEntity(pipe);
+    auto pipeIDs = std::vector<EntityID>(pipes.begin(), pipes.end());
+    ecs.entities.destroyBatch(pipeIDs);
     pipes.clear();
 
     ecs.tasks.deleteTask<AttachedCameraController>();
@@ -98,8 +97,8 @@ bool PlayState::receive(CollisionEvent& collision) {
             auto leftScreenBoundary = window.getView().getCenter().x - window.getView().getSize().x / 2;
             auto oldestPipePosition = ecs.components.getComponent<PositionComponent>(pipes[0])->position.x;
             if (oldestPipePosition < leftScreenBoundary) {
-                ecs.entities.deleteEntity(pipes[0]);    
-                ecs.entities.deleteEntity(pipes[1]);
+                ecs.commands.deleteEntity(pipes[0]);
+                ecs.commands.deleteEntity(pipes[1]);
                 pipes.erase(begin(pipes));
                 pipes.erase(begin(pipes));
             }
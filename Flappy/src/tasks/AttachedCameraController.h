@@ -5,7 +5,7 @@
 
 using namespace EECS;
 
-class AttachedCameraController : public Task<AttachedCameraController> {
+class AttachedCameraController : public Task<AttachedCameraController, MainThread, Reads<PositionComponent>> {
 public:
 	AttachedCameraController(ECS& engine, sf::RenderWindow& window, Entity& attachmentPoint, sf::Vector2f offset,
 	                         bool followX, bool followY) :
@@ -18,8 +18,13 @@ public:
     }
 
 	void update() override {
+		//camera moves only when the entity it follows does
+		auto position = engine.components.getComponent<const PositionComponent>(attachmentPoint.getID());
+		if (!position || position->changedTick <= lastUpdateTick)
+			return;
+
 		auto view = window.getView();
-		auto desiredPos = attachmentPoint.component<PositionComponent>()->position + offset;
+		auto desiredPos = position->position + offset;
 		auto finalPos = sf::Vector2f{followX ? desiredPos.x : view.getCenter().x,
                                      followY ? desiredPos.y : view.getCenter().y};
 		view.setCenter(finalPos);
@@ -8,7 +8,7 @@ struct MouseWheelMoved;
 struct MouseButtonPressed;
 struct MouseButtonReleased;
 struct MouseMoved;
-class CameraMouseController : public Task<CameraMouseController>, Receives<CameraMouseController, MouseWheelMoved, MouseButtonPressed, MouseButtonReleased, MouseMoved> {
+class CameraMouseController : public Task<CameraMouseController, Reads<>>, Receives<CameraMouseController, MouseWheelMoved, MouseButtonPressed, MouseButtonReleased, MouseMoved> {
 public:
 	CameraMouseController(ECS& engine, sf::RenderWindow& window);
 	void update() override;
@@ -20,61 +20,114 @@ public:
 };
 
 void CollisionDetector::update() {
-    auto bodies = ecs.components.intersection<CollisionComponent, PositionComponent, SizeComponent>();
-
-    //check each body-body pair for collision
-    for(auto i = 0u; i < bodies.size(); i++) {
-        for(auto j = i + 1; j < bodies.size(); j++) {
-            auto a = bodies[i];
-            auto b = bodies[j];
-
-            bool emitEvent = a.get<CollisionComponent>().emitEvent || b.get<CollisionComponent>().emitEvent;
-            bool pushAnything = a.get<CollisionComponent>().pushFromCollision || b.get<CollisionComponent>().pushFromCollision;
-            bool bothStatic = a.get<CollisionComponent>().isStatic || b.get<CollisionComponent>().isStatic;
-            bool checkRequired = emitEvent || pushAnything || !bothStatic;
-            if(!checkRequired)
-                continue;
-
-            auto firstBodyVertices = getVertices(a.get<PositionComponent>(), a.get<SizeComponent>());
-            auto secondBodyVertices = getVertices(b.get<PositionComponent>(), b.get<SizeComponent>());
-            auto MTV = calculateCollision(firstBodyVertices, secondBodyVertices);
-
-            auto bodiesCollide = MTV.x != 0.f || MTV.y != 0.f;
-            if(bodiesCollide) {
-                auto firstBodyTranslation = sf::Vector2f{};
-                auto secondBodyTranslation = sf::Vector2f{};
-
-                if(a.get<CollisionComponent>().pushFromCollision) {
-                    //if both are to be pushed, push each by 1/2 of MTV in opposite directions.
-                    if(b.get<CollisionComponent>().pushFromCollision) {
-                        firstBodyTranslation = {MTV.x / 2.f, MTV.y / 2.f};
-                        secondBodyTranslation = {-MTV.x / 2.f, -MTV.y / 2.f};
-                    } else {
-                        firstBodyTranslation = MTV;
-                    }
-                } else if(b.get<CollisionComponent>().pushFromCollision) {
-                    secondBodyTranslation = -MTV;
-                }
-                a.get<PositionComponent>().position += firstBodyTranslation;
-                b.get<PositionComponent>().position += secondBodyTranslation;
-
-                if(a.get<CollisionComponent>().emitEvent || b.get<CollisionComponent>().emitEvent) {
-                    CollisionEvent event;
-                    
-                    event.firstBody = a.entity();
-                    event.secondBody = b.entity();
-                    event.firstBodyTranslation = firstBodyTranslation;
-                    event.secondBodyTranslation = secondBodyTranslation;
-                    event.minimumTranslationVector = MTV;
-                    ecs.events.push(std::move(event));
-                }
-
-                if(auto movementComponent = ecs.components.getComponent<MovementComponent>(a.get<PositionComponent>().entityID))
-                    movementComponent->oldPosition += firstBodyTranslation;
-                if(auto movementComponent = ecs.components.getComponent<MovementComponent>(b.get<PositionComponent>().entityID))
-                    movementComponent->oldPosition += secondBodyTranslation;
+    //broad phase: bodies are bucketed by their bounding boxes, so only nearby ones are checked further. Only bodies
+    //which moved, were resized, rotated or appeared since the last update have to be rebucketed
+    auto updateBodies = [this](auto&& changedBodies) {
+        for (auto components : changedBodies) {
+            updateBody(std::get<0>(components), std::get<1>(components), std::get<2>(components),
+                       std::get<3>(components));
+        }
+    };
+    updateBodies(ecs.components.view<const CollisionComponent, Changed<const PositionComponent>, const SizeComponent>(
+        lastUpdateTick));
+    updateBodies(ecs.components.view<const CollisionComponent, const PositionComponent, Changed<const SizeComponent>>(
+        lastUpdateTick));
+    updateBodies(ecs.components.view<Changed<const CollisionComponent>, const PositionComponent, const SizeComponent>(
+        lastUpdateTick));
+    updateBodies(ecs.components.view<const CollisionComponent, const PositionComponent, const SizeComponent,
+                                     Changed<const OrientationComponent>>(lastUpdateTick));
+
+    //all bodies are in the broad phase now, so if there are more of them, some were deleted
+    auto& bodies = ecs.components.group<const CollisionComponent, const PositionComponent, const SizeComponent>();
+    if (broadPhase.size() != bodies.size()) {
+        broadPhase.removeIf([&bodies](EntityID entity) { return !bodies.contains(entity); });
+    }
+
+    broadPhase.forEachPair([this](EntityID first, EntityID second) { resolveCollision(first, second); });
+
+    //bodies pushed apart were changed by this update, so the next one won't see them as changed
+    for (auto entity : pushedBodies) {
+        updateBody(entity, *ecs.components.getComponent<const CollisionComponent>(entity),
+                   *ecs.components.getComponent<const PositionComponent>(entity),
+                   *ecs.components.getComponent<const SizeComponent>(entity));
+    }
+    pushedBodies.clear();
+}
+
+void CollisionDetector::updateBody(EntityID entity, const CollisionComponent& collision,
+                                   const PositionComponent& position, const SizeComponent& size) {
+    auto vertices = getVertices(position, size);
+    auto box = SpatialHash::Box{vertices[0].x, vertices[0].y, vertices[0].x, vertices[0].y};
+    for (auto vertice : vertices) {
+        box.left = std::min(box.left, vertice.x);
+        box.top = std::min(box.top, vertice.y);
+        box.right = std::max(box.right, vertice.x);
+        box.bottom = std::max(box.bottom, vertice.y);
+    }
+    broadPhase.update(entity, box, collision.isStatic);
+}
+
+//narrow phase: checks if bodies really collide, and if so separates them and emits event
+void CollisionDetector::resolveCollision(EntityID aEntity, EntityID bEntity) {
+    auto aCollision = ecs.components.getComponent<const CollisionComponent>(aEntity);
+    auto bCollision = ecs.components.getComponent<const CollisionComponent>(bEntity);
+    auto aPosition = ecs.components.getComponent<const PositionComponent>(aEntity);
+    auto bPosition = ecs.components.getComponent<const PositionComponent>(bEntity);
+    auto aSize = ecs.components.getComponent<const SizeComponent>(aEntity);
+    auto bSize = ecs.components.getComponent<const SizeComponent>(bEntity);
+
+    bool emitEvent = aCollision->emitEvent || bCollision->emitEvent;
+    bool pushAnything = aCollision->pushFromCollision || bCollision->pushFromCollision;
+    if(!(emitEvent || pushAnything))
+        return;
+
+    //rotated bodies need SAT, for the rest it's enough to compare rectangles
+    auto rotated = ecs.components.getComponent<const OrientationComponent>(aEntity) ||
+                   ecs.components.getComponent<const OrientationComponent>(bEntity);
+    auto MTV = rotated ? calculateCollision(getVertices(*aPosition, *aSize), getVertices(*bPosition, *bSize))
+                       : calculateCollision(*aPosition, *aSize, *bPosition, *bSize);
+
+    auto bodiesCollide = MTV.x != 0.f || MTV.y != 0.f;
+    if(bodiesCollide) {
+        auto firstBodyTranslation = sf::Vector2f{};
+        auto secondBodyTranslation = sf::Vector2f{};
+
+        if(aCollision->pushFromCollision) {
+            //if both are to be pushed, push each by 1/2 of MTV in opposite directions.
+            if(bCollision->pushFromCollision) {
+                firstBodyTranslation = {MTV.x / 2.f, MTV.y / 2.f};
+                secondBodyTranslation = {-MTV.x / 2.f, -MTV.y / 2.f};
+            } else {
+                firstBodyTranslation = MTV;
             }
+        } else if(bCollision->pushFromCollision) {
+            secondBodyTranslation = -MTV;
+        }
+        //only bodies which are really pushed are marked as changed, so pipes stay where they were bucketed
+        if(aCollision->pushFromCollision) {
+            ecs.components.getComponent<PositionComponent>(aEntity)->position += firstBodyTranslation;
+            pushedBodies.push_back(aEntity);
         }
+        if(bCollision->pushFromCollision) {
+            ecs.components.getComponent<PositionComponent>(bEntity)->position += secondBodyTranslation;
+            pushedBodies.push_back(bEntity);
+        }
+
+        if(aCollision->emitEvent || bCollision->emitEvent) {
+            CollisionEvent event;
+            
+            event.firstBody = aEntity;
+            event.secondBody = bEntity;
+            event.firstBodyTranslation = firstBodyTranslation;
+            event.secondBodyTranslation = secondBodyTranslation;
+            event.minimumTranslationVector = MTV;
+            ecs.events.push(std::move(event));
+        }
+
+        if(auto movementComponent = ecs.components.getComponent<MovementComponent>(aEntity))
+            movementComponent->oldPosition += firstBodyTranslation;
+        if(auto movementComponent = ecs.components.getComponent<MovementComponent>(bEntity))
+            movementComponent->oldPosition += secondBodyTranslation;
     }
 }
 
@@ -129,13 +182,35 @@ sf::Vector2f CollisionDetector::calculateCollision(const std::array<sf::Vector2f
     return MTV;
 }
 
+//returns MTV that you can apply to first, for bodies which aren't rotated. MTV == 0.f if they don't collide
+sf::Vector2f CollisionDetector::calculateCollision(const PositionComponent& firstPosition, const SizeComponent& firstSize,
+                                                   const PositionComponent& secondPosition, const SizeComponent& secondSize) {
+    auto first = sf::FloatRect(firstPosition.position, {firstSize.width, firstSize.height});
+    auto second = sf::FloatRect(secondPosition.position, {secondSize.width, secondSize.height});
+
+    auto overlapX = std::min(first.left + first.width, second.left + second.width) - std::max(first.left, second.left);
+    auto overlapY = std::min(first.top + first.height, second.top + second.height) - std::max(first.top, second.top);
+    if(overlapX <= 0.f || overlapY <= 0.f) {
+        return {0.f, 0.f};
+    }
+
+    //push first body along the axis of smaller overlap, away from center of the second one
+    if(overlapX < overlapY) {
+        auto firstIsLeft = first.left + first.width / 2.f < second.left + second.width / 2.f;
+        return {firstIsLeft ? -overlapX : overlapX, 0.f};
+    }
+
+    auto firstIsAbove = first.top + first.height / 2.f < second.top + second.height / 2.f;
+    return {0.f, firstIsAbove ? -overlapY : overlapY};
+}
+
 float CollisionDetector::overlap(Projection first, Projection second) {
     return std::max(0.f, std::min(first.max, second.max) - std::max(first.min, second.min));
 }
 
 std::array<sf::Vector2f, 4> CollisionDetector::getVertices(const PositionComponent& pos, const SizeComponent& size) {
     auto transform = sf::Transform{};
-    auto orientation = ecs.components.getComponent<OrientationComponent>(pos.entityID);
+    auto orientation = ecs.components.getComponent<const OrientationComponent>(pos.entityID);
     if(orientation) {
         transform.rotate(orientation->rotation,
                          pos.position.x + size.width / 2,
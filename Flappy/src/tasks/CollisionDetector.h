@@ -6,22 +6,39 @@
 using namespace EECS;
 
 class Projection;
+struct CollisionComponent;
 struct PositionComponent;
 struct SizeComponent;
-class CollisionDetector : public Task<CollisionDetector> {
+struct MovementComponent;
+struct OrientationComponent;
+struct CollisionEvent;
+class CollisionDetector : public Task<CollisionDetector, Reads<CollisionComponent, SizeComponent, OrientationComponent>,
+                                                         Writes<PositionComponent, MovementComponent, CollisionEvent>> {
 public:
 	CollisionDetector(ECS& engine, sf::RenderWindow& window) :
 			Task(engine),
-			window(window) {
+			window(window),
+			broadPhase(engine.config.get("tasks.collisionDetector.cellSize", 1.f)) {
 	}
 	void update() override;
 
 private:
     sf::Vector2f calculateCollision(const std::array<sf::Vector2f, 4>& first, const std::array<sf::Vector2f, 4>& secnd);
+    sf::Vector2f calculateCollision(const PositionComponent& firstPosition, const SizeComponent& firstSize,
+                                    const PositionComponent& secondPosition, const SizeComponent& secondSize);
     float overlap(Projection first, Projection second);
     std::array<sf::Vector2f, 4> getVertices(const PositionComponent& position, const SizeComponent& size);
     void appendAxes(std::vector<sf::Vector2f>& where, const std::array<sf::Vector2f, 4>& sourceVertices);
+    void resolveCollision(EntityID first, EntityID second);
+    void updateBody(EntityID entity, const CollisionComponent& collision, const PositionComponent& position,
+                    const SizeComponent& size);
 
 	sf::RenderWindow& window;
+
+    // bodies which take part in collision detection. Kept between updates, so static ones are bucketed once.
+    SpatialHash broadPhase;
+
+    // bodies moved by resolveCollision during current update
+    std::vector<EntityID> pushedBodies;
 };
 
@@ -11,7 +11,7 @@
 
 using namespace EECS;
 
-InputEcho::InputEcho(ECS& engine) : Task<InputEcho>(engine), debugLogger("DEBUG") {
+InputEcho::InputEcho(ECS& engine) : Task(engine), debugLogger("DEBUG") {
 	if(engine.config.get("tasks.debugTask.log") == "true") {
 		auto cOut = std::make_shared<ConsoleOutput>();
 		cOut->setMinPriority(LogType::Information);
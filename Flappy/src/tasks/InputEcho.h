@@ -12,7 +12,7 @@ struct MouseButtonPressed;
 struct MouseButtonReleased;
 struct MouseMoved;
 struct MouseWheelMoved;
-class InputEcho : public Task<InputEcho>, Receives<InputEcho, UnknownSFMLEvent, ApplicationClosedEvent, KeyPressed, KeyReleased, TextEntered, MouseButtonPressed, MouseButtonReleased, MouseMoved, MouseWheelMoved> {
+class InputEcho : public Task<InputEcho, Reads<>>, Receives<InputEcho, UnknownSFMLEvent, ApplicationClosedEvent, KeyPressed, KeyReleased, TextEntered, MouseButtonPressed, MouseButtonReleased, MouseMoved, MouseWheelMoved> {
 public:
 	InputEcho(ECS& engine);
 
@@ -4,23 +4,22 @@
 
 using namespace EECS;
 
-VerletIntegrator::VerletIntegrator(ECS& engine) : Task<VerletIntegrator>(engine) { }
+VerletIntegrator::VerletIntegrator(ECS& engine) : Task(engine) { }
 
 void VerletIntegrator::update() {
-    auto elapsedTime = (float)frequency.count() / 1000;
+    auto elapsedTime = std::chrono::duration<float>(frequency).count();
 
-	auto physical = ecs.components.intersection<MovementComponent, PositionComponent>();
-	for (auto&& obj : physical) {
-		for(auto&& force : obj.get<MovementComponent>().persistentForces)
-			obj.get<MovementComponent>().resultantForce += force;
+	for (auto [entity, movement, position] : ecs.components.view<MovementComponent, PositionComponent>()) {
+		for(auto&& force : movement.persistentForces)
+			movement.resultantForce += force;
 
-		auto currentPosition = obj.get<PositionComponent>().position;
-        auto velocity = currentPosition - obj.get<MovementComponent>().oldPosition;
-		auto acceleration = obj.get<MovementComponent>().resultantForce / obj.get<MovementComponent>().mass;
-		obj.get<PositionComponent>().position = obj.get<PositionComponent>().position + velocity + acceleration * (elapsedTime*elapsedTime);
+		auto currentPosition = position.position;
+        auto velocity = currentPosition - movement.oldPosition;
+		auto acceleration = movement.resultantForce / movement.mass;
+		position.position = position.position + velocity + acceleration * (elapsedTime*elapsedTime);
 
-		obj.get<MovementComponent>().oldPosition = currentPosition;
-		obj.get<MovementComponent>().resultantForce = {0, 0};
+		movement.oldPosition = currentPosition;
+		movement.resultantForce = {0, 0};
 	}
 }
 
@@ -3,7 +3,9 @@
 
 using namespace EECS;
 
-class VerletIntegrator : public Task<VerletIntegrator> {
+struct MovementComponent;
+struct PositionComponent;
+class VerletIntegrator : public Task<VerletIntegrator, Writes<MovementComponent, PositionComponent>> {
 public:
     VerletIntegrator(ECS& engine);
     void update() override;
@@ -2,6 +2,8 @@
 #include <ecs/ecs.h>
 
 struct CollisionComponent : public Component<CollisionComponent> {
+    static constexpr ComponentStorage storage = ComponentStorage::SparseSet;
+
     //if true, then body will be automatically pushed apart from collision by minimum possible distance
     //if true in both Entity's CollisionComponents, then both bodies are pushed by 1/2 of collision area
     //affects PositionComponent
@@ -3,6 +3,8 @@
 #include <ecs/ecs.h>
 
 struct PositionComponent : public Component<PositionComponent> {
+    static constexpr ComponentStorage storage = ComponentStorage::SparseSet;
+
 	explicit PositionComponent(float x = 0, float y = 0) : position(x,y) { }
 
     //Point(vector with fixed orgin at (0, 0) with this Entity's position in world
@@ -1,6 +1,7 @@
 #pragma once
 #include <ecs/ecs.h>
 #include <SFML/System.hpp>
+#include <array>
 
 using namespace EECS;
 
@@ -18,4 +19,7 @@ struct CollisionEvent : public Event<CollisionEvent> {
     //push it from collision by minimum possible distance. To be applied to second body, flip sign
     //0 if bodies were translated already
 	sf::Vector2f minimumTranslationVector = {0.f, 0.f};
+
+    //lets receivers subscribe to collisions of particular body
+    std::array<EntityID, 2> entities() const { return {firstBody, secondBody}; }
 };
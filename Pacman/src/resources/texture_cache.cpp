@@ -0,0 +1,88 @@
+#include "texture_cache.h"
+#include <algorithm>
+
+std::shared_ptr<sf::Texture> TextureCache::load(const std::string& path) {
+    if (auto found = textures.find(path); found != textures.end())
+        return found->second;
+
+    auto texture = std::make_shared<sf::Texture>();
+    if (!texture->loadFromFile(path))
+        return nullptr;
+
+    textures[path] = texture;
+    return texture;
+}
+
+TextureRegion TextureCache::get(const std::string& path) {
+    if (auto found = atlasRegions.find(path); found != atlasRegions.end())
+        return found->second;
+
+    auto region = TextureRegion{load(path)};
+    if (region.texture)
+        region.rect = { 0, 0, (int)region.texture->getSize().x, (int)region.texture->getSize().y };
+    return region;
+}
+
+bool TextureCache::buildAtlas(const std::vector<std::string>& paths, unsigned maxSize) {
+    struct Packed {
+        std::string path;
+        sf::Image image;
+        sf::IntRect rect;
+    };
+
+    auto packed = std::vector<Packed>{};
+    for (const auto& path : paths) {
+        auto alreadyPacked = atlasRegions.count(path) ||
+            std::any_of(packed.begin(), packed.end(), [&](const Packed& other) { return other.path == path; });
+        if (alreadyPacked)
+            continue;
+
+        auto image = sf::Image{};
+        if (image.loadFromFile(path))
+            packed.push_back({path, image});
+    }
+    if (packed.empty())
+        return true;
+
+    //shelf packing - images are put in rows from the tallest, so rows waste little space. One pixel of padding
+    //between images keeps filtering from bleeding neighbours in
+    const auto padding = 1u;
+    std::sort(packed.begin(), packed.end(), [](const Packed& first, const Packed& second) {
+        return first.image.getSize().y > second.image.getSize().y;
+    });
+
+    auto x = 0u, y = 0u, rowHeight = 0u, width = 0u;
+    for (auto& image : packed) {
+        auto size = image.image.getSize();
+        if (x + size.x > maxSize) {
+            x = 0;
+            y += rowHeight + padding;
+            rowHeight = 0;
+        }
+        if (x + size.x > maxSize || y + size.y > maxSize)
+            return false;
+
+        image.rect = { (int)x, (int)y, (int)size.x, (int)size.y };
+        x += size.x + padding;
+        rowHeight = std::max(rowHeight, size.y);
+        width = std::max(width, x);
+    }
+
+    auto atlasImage = sf::Image{};
+    atlasImage.create(width, y + rowHeight, sf::Color::Transparent);
+    for (const auto& image : packed)
+        atlasImage.copy(image.image, image.rect.left, image.rect.top);
+
+    auto atlas = std::make_shared<sf::Texture>();
+    if (!atlas->loadFromImage(atlasImage))
+        return false;
+
+    for (const auto& image : packed)
+        atlasRegions[image.path] = { atlas, image.rect };
+    return true;
+}
+
+void TextureCache::clear() {
+    textures.clear();
+    atlasRegions.clear();
+}
@@ -0,0 +1,35 @@
+#pragma once
+#include <SFML/Graphics.hpp>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+//part of a texture which holds single image
+struct TextureRegion {
+    std::shared_ptr<sf::Texture> texture = nullptr;
+    sf::IntRect rect; //in pixels
+};
+
+//loads every texture only once, no matter how many entities use it. Small images can be packed together into
+//a single atlas texture, so that sprites which use them are drawn in the same batch.
+class TextureCache {
+public:
+    //returns texture loaded from given file, loading it only the first time. Null if it can't be loaded.
+    std::shared_ptr<sf::Texture> load(const std::string& path);
+
+    //returns region of image loaded from given file - part of the atlas if it was packed into it, or whole texture
+    //otherwise. Texture is null if file can't be loaded.
+    TextureRegion get(const std::string& path);
+
+    //packs images from given files into single texture of at most maxSize x maxSize pixels. Images which were
+    //already packed, or which can't be loaded, are skipped. Returns false if they don't fit - then nothing is packed.
+    bool buildAtlas(const std::vector<std::string>& paths, unsigned maxSize);
+
+    //forgets all textures. They're freed once no entity uses them anymore.
+    void clear();
+
+private:
+    std::unordered_map<std::string, std::shared_ptr<sf::Texture>> textures;
+    std::unordered_map<std::string, TextureRegion> atlasRegions;
+};
@@ -1,6 +1,7 @@
 #include "play_state.h"
 #include <random>
 #include <ctime>
+#include <algorithm>
 #include <math.h>
 #include "../events/system_events.h"
 #include "../events/collision_event.h"
@@ -11,19 +12,28 @@
 #include "../components/graphics_component.h"
 #include "../components/gui_text_component.h"
 
-PlayState::PlayState(ECS& ecs, sf::RenderWindow& window) : ecs(ecs), Receives(ecs.events), window(window) {
+PlayState::PlayState(ECS& ecs, sf::RenderWindow& window, TextureCache& textures) :
+    ecs(ecs), Receives(ecs.events), window(window), textures(textures) {
 	init();
 }
 
+PlayState::~PlayState() {
+    ecs.events.disconnect<CollisionEvent>(*this);
+}
+
 void PlayState::init() {
 	pacman = createPacman("gameplay.pacman");
     pacman2 = createPacman("gameplay.secondPacman");
+    //only collisions of pacmans are of interest
+    ecs.events.connect<CollisionEvent>(*this, pacman.getID());
+    ecs.events.connect<CollisionEvent>(*this, pacman2.getID());
 	scoreCounterP1 = createScoreCounter(0.25);
     scoreCounterP2 = createScoreCounter(0.75);
     createMaze();
 }
 
 void PlayState::cleanup() {
+    ecs.events.disconnect<CollisionEvent>(*this);
     pacman.deleteEntity();
     pacman2.deleteEntity();
     scoreP1 = 0;
@@ -31,10 +41,10 @@ void PlayState::cleanup() {
     scoreP2 = 0;
     scoreCounterP2.deleteEntity();
 
-    for (auto wall : walls)
-        ecs.entities.deleteEntity(wall);
-    for (auto pellet : pellets)
-        ecs.entities.deleteEntity(pellet);
+    ecs.entities.destroyBatch(walls);
+    walls.clear();
+    ecs.entities.destroyBatch(pellets);
+    pellets.clear();
 }
 
 bool PlayState::receive(ApplicationClosed&) {
@@ -73,12 +83,26 @@ bool PlayState::receive(KeyPressed& keystroke) {
     return true;
 }
 
-bool PlayState::receive(CollisionEvent& collision) {
+size_t PlayState::receive(std::span<CollisionEvent> collisions) {
+    //collisions of pacmen are consumed, the rest is moved to the front and spreads further
+    auto kept = size_t{0};
+    for (auto i = size_t{0}; i < collisions.size(); i++) {
+        if (handleCollision(collisions[i])) {
+            if (kept != i)
+                collisions[kept] = std::move(collisions[i]);
+            kept++;
+        }
+    }
+
+    return kept;
+}
+
+bool PlayState::handleCollision(const CollisionEvent& collision) {
     if (collision.firstBody == pacman.getID() || collision.secondBody == pacman.getID()) {
         auto collidingID = collision.firstBody != pacman.getID() ? collision.firstBody : collision.secondBody;
 
-        if (std::find(begin(pellets), end(pellets), collidingID) != end(pellets)) {
-            ecs.entities.deleteEntity(collidingID);
+        if (std::binary_search(begin(pellets), end(pellets), collidingID)) {
+            ecs.commands.deleteEntity(collidingID);
             scoreP1++;
             if (auto text = ecs.components.getComponent<GUITextComponent>(scoreCounterP1))
                 text->text.setString(std::to_string(scoreP1));
@@ -91,8 +115,8 @@ bool PlayState::receive(CollisionEvent& collision) {
     if (collision.firstBody == pacman2.getID() || collision.secondBody == pacman2.getID()) {
         auto collidingID = collision.firstBody != pacman2.getID() ? collision.firstBody : collision.secondBody;
 
-        if (std::find(begin(pellets), end(pellets), collidingID) != end(pellets)) {
-            ecs.entities.deleteEntity(collidingID);
+        if (std::binary_search(begin(pellets), end(pellets), collidingID)) {
+            ecs.commands.deleteEntity(collidingID);
             scoreP2++;
             if (auto text = ecs.components.getComponent<GUITextComponent>(scoreCounterP2))
                 text->text.setString(std::to_string(scoreP2));
@@ -136,9 +160,11 @@ Entity PlayState::createPacman(const std::string& configRoot) {
     pacmanCollision->emitEvent = true;
     pacmanCollision->pushFromCollision = true;
 
+    //texture is shared with other sprites, loaded only once
     auto pacmanAppearance = pacman.addComponent<GraphicsComponent>();
-    pacmanAppearance->texture = std::make_shared<sf::Texture>();
-    pacmanAppearance->texture->loadFromFile(ecs.config.get(configRoot + ".texture"));
+    auto pacmanTexture = textures.get(ecs.config.get(configRoot + ".texture"));
+    pacmanAppearance->texture = pacmanTexture.texture;
+    pacmanAppearance->textureRect = pacmanTexture.rect;
     
     return pacman;
 }
@@ -190,19 +216,39 @@ void PlayState::createMaze() {
     int mazeWidth = 19;
     int mazeHeight = 22;
 
+    std::vector<sf::Vector2i> wallTiles;
+    std::vector<sf::Vector2i> pelletTiles;
     for (int i = 0; i < mazeWidth; i++)
         for (int j = 0; j < mazeHeight; j++) {
             char tileKind = *(mazeLayout + mazeWidth*j + i);
             if (tileKind == '#')
-                createWallSegment(i, j);
+                wallTiles.push_back({i, j});
             else if (tileKind == '.')
-                createFoodPellet(i, j);
+                pelletTiles.push_back({i, j});
         }
+
+    //first tile of each kind is created normally, and the rest are its copies, created at once
+    walls = fillTiles(createWallSegment(wallTiles[0].x, wallTiles[0].y), wallTiles);
+    pellets = fillTiles(createFoodPellet(pelletTiles[0].x, pelletTiles[0].y), pelletTiles);
+    std::sort(begin(pellets), end(pellets));
 }
 
-void PlayState::createWallSegment(int posX, int posY) {
+std::vector<EntityID> PlayState::fillTiles(Entity prototype, const std::vector<sf::Vector2i>& tiles) {
+    static auto tileSize = ecs.config.get<float>("gameplay.map.tileSize");
+
+    auto entities = ecs.entities.spawnBatch(tiles.size() - 1, prototype);
+    auto origin = prototype.component<PositionComponent>()->position;
+    for (auto i = 1u; i < tiles.size(); i++) {
+        auto offset = sf::Vector2f(tiles[i] - tiles[0]) * tileSize;
+        ecs.components.getComponent<PositionComponent>(entities[i - 1])->position = origin + offset;
+    }
+
+    entities.push_back(prototype);
+    return entities;
+}
+
+Entity PlayState::createWallSegment(int posX, int posY) {
     auto wall = ecs.entities.addEntity();
-    walls.push_back(wall);
 
     static auto tileSize = ecs.config.get<float>("gameplay.map.tileSize");
     static auto tileOriginX = ecs.config.get<float>("gameplay.map.origin.x");
@@ -216,11 +262,12 @@ void PlayState::createWallSegment(int posX, int posY) {
 
     auto wallAppearance = wall.addComponent<GraphicsComponent>();
     wallAppearance->color = sf::Color::Blue;
+
+    return wall;
 }
 
-void PlayState::createFoodPellet(int posX, int posY) {
+Entity PlayState::createFoodPellet(int posX, int posY) {
     auto pellet = ecs.entities.addEntity();
-    pellets.push_back(pellet);
 
     static auto tileSize = ecs.config.get<float>("gameplay.map.tileSize");
     static auto tileOriginX = ecs.config.get<float>("gameplay.map.origin.x");
@@ -234,4 +281,6 @@ void PlayState::createFoodPellet(int posX, int posY) {
 
     auto pelletAppearance = pellet.addComponent<GraphicsComponent>();
     pelletAppearance->color = sf::Color::Yellow;
+
+    return pellet;
 }
\ No newline at end of file
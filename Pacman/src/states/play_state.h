@@ -2,46 +2,52 @@
 #include "State.h"
 #include <ecs/ecs.h>
 #include <SFML/Graphics.hpp>
+#include <span>
+#include "../events/collision_event.h"
+#include "../resources/texture_cache.h"
 
 using namespace EECS;
 struct ApplicationClosed;
 struct MouseButtonPressed;
 struct KeyPressed;
-struct CollisionEvent;
 
-class PlayState : public State, Receives<PlayState, ApplicationClosed, MouseButtonPressed, KeyPressed, CollisionEvent> {
+class PlayState : public State, Receives<PlayState, ApplicationClosed, MouseButtonPressed, KeyPressed> {
 public:
-	PlayState(ECS& engine, sf::RenderWindow& window);
+	PlayState(ECS& engine, sf::RenderWindow& window, TextureCache& textures);
+    ~PlayState();
 	bool receive(ApplicationClosed& closeRequest);
     bool receive(MouseButtonPressed& buttonPress);
     bool receive(KeyPressed& buttonPress);
-    bool receive(CollisionEvent& collision);
+    size_t receive(std::span<CollisionEvent> collisions);
 
 private:
     void init();
     void cleanup();
 
+    //returns false if collision concerned one of pacmen, so it's consumed
+    bool handleCollision(const CollisionEvent& collision);
+
     Entity createPacman(const std::string& configRoot);
     Entity createScoreCounter(float pos);
     void createMaze();
-    void createWallSegment(int posX, int posY);
-    void createFoodPellet(int posX, int posY);
+    Entity createWallSegment(int posX, int posY);
+    Entity createFoodPellet(int posX, int posY);
+    std::vector<EntityID> fillTiles(Entity prototype, const std::vector<sf::Vector2i>& tiles);
 
     Entity pacman;
-    std::shared_ptr<sf::Texture> pacmanTex = std::make_shared<sf::Texture>();
     int scoreP1 = 0;
     Entity scoreCounterP1;
 
     Entity pacman2;
-    std::shared_ptr<sf::Texture> pacman2Tex = std::make_shared<sf::Texture>();
     int scoreP2 = 0;
     Entity scoreCounterP2;
     
     sf::Font counterFont;
 
-	std::vector<EntityID> pellets;
+	std::vector<EntityID> pellets; // sorted, so colliding pellets are found by binary search
     std::vector<EntityID> walls;
     
     ECS& ecs;   
     sf::RenderWindow& window;
+    TextureCache& textures;
 };
@@ -6,146 +6,117 @@
 #include "../components/position_component.h"
 #include "../components/size_component.h"
 
-//class representing 2D projection of figure on axis. Invalid until it contains at least one point
-class Projection {
-public:
-    float min = std::numeric_limits<float>::max();
-    float max = std::numeric_limits<float>::lowest();
-
-    void addPoint(float projectedPoint) {
-        min = projectedPoint < min ? projectedPoint : min; 
-        max = projectedPoint > max ? projectedPoint : max; 
-    }
-};
-
 void CollisionDetector::update() {
-    auto bodies = ecs.components.intersection<CollisionComponent, PositionComponent, SizeComponent>();
-
-    //check each body-body pair for collision
-    for(auto i = 0u; i < bodies.size(); i++) {
-        for(auto j = i + 1; j < bodies.size(); j++) {
-            auto a = bodies[i];
-            auto b = bodies[j];
-            
-            bool bothStatic = a.get<CollisionComponent>().isStatic && b.get<CollisionComponent>().isStatic;
-            if (bothStatic)
-                continue;
-
-            bool emitEvent = a.get<CollisionComponent>().emitEvent || b.get<CollisionComponent>().emitEvent;
-            bool pushAnything = a.get<CollisionComponent>().pushFromCollision || b.get<CollisionComponent>().pushFromCollision;
-            if (!(emitEvent || pushAnything))
-                continue;
-
-            auto firstBodyVertices = getVertices(a.get<PositionComponent>(), a.get<SizeComponent>());
-            auto secondBodyVertices = getVertices(b.get<PositionComponent>(), b.get<SizeComponent>());
-            auto MTV = calculateCollision(firstBodyVertices, secondBodyVertices);
-
-            auto bodiesCollide = MTV.x != 0.f || MTV.y != 0.f;
-            if(bodiesCollide) {
-                auto firstBodyTranslation = sf::Vector2f{};
-                auto secondBodyTranslation = sf::Vector2f{};
-
-                if(a.get<CollisionComponent>().pushFromCollision) {
-                    //if both are to be pushed, push each by 1/2 of MTV in opposite directions.
-                    if(b.get<CollisionComponent>().pushFromCollision) {
-                        firstBodyTranslation = {MTV.x / 2.f, MTV.y / 2.f};
-                        secondBodyTranslation = {-MTV.x / 2.f, -MTV.y / 2.f};
-                    } else
-                        firstBodyTranslation = MTV;
-                } else if(b.get<CollisionComponent>().pushFromCollision)
-                    secondBodyTranslation = -MTV;
-
-                a.get<PositionComponent>().position += firstBodyTranslation;
-                b.get<PositionComponent>().position += secondBodyTranslation;
-
-                if(a.get<CollisionComponent>().emitEvent || b.get<CollisionComponent>().emitEvent) {
-                    CollisionEvent event;
-                    
-                    event.firstBody = a.entity();
-                    event.secondBody = b.entity();
-                    event.firstBodyTranslation = firstBodyTranslation;
-                    event.secondBodyTranslation = secondBodyTranslation;
-                    event.minimumTranslationVector = MTV;
-                    ecs.events.push(std::move(event));
-                }
-            }
+    //broad phase: bodies are bucketed by their bounding boxes, so only nearby ones are checked further. Only bodies
+    //which moved, were resized or appeared since the last update have to be rebucketed
+    auto updateBodies = [this](auto&& changedBodies) {
+        for (auto [entity, collision, position, size] : changedBodies) {
+            updateBody(entity, collision, position, size);
         }
+    };
+    updateBodies(ecs.components.view<const CollisionComponent, Changed<const PositionComponent>, const SizeComponent>(
+        lastUpdateTick));
+    updateBodies(ecs.components.view<const CollisionComponent, const PositionComponent, Changed<const SizeComponent>>(
+        lastUpdateTick));
+    updateBodies(ecs.components.view<Changed<const CollisionComponent>, const PositionComponent, const SizeComponent>(
+        lastUpdateTick));
+
+    //all bodies are in the broad phase now, so if there are more of them, some were deleted
+    auto& bodies = ecs.components.group<const CollisionComponent, const PositionComponent, const SizeComponent>();
+    if (broadPhase.size() != bodies.size()) {
+        broadPhase.removeIf([&bodies](EntityID entity) { return !bodies.contains(entity); });
     }
-}
 
-//returns MTV that you can apply to first. MTV == 0.f if they don't collide
-sf::Vector2f CollisionDetector::calculateCollision(const std::array<sf::Vector2f, 4>& first,
-                                                   const std::array<sf::Vector2f, 4>& second) {
-    std::vector<sf::Vector2f> axes;
-    appendAxes(axes, first);
-    appendAxes(axes, second);
-
-    auto minOverlap = std::numeric_limits<float>::max();
-    auto minOverlapAxis = axes[0];
-    auto minOverlapSecondProjection = Projection{};
-
-    for(auto axis : axes) {
-        //project bodies
-        auto projection = Projection{};
-        auto projection2 = Projection{};
-        for(auto&& vertice : first)
-            projection.addPoint(vertice.x*axis.x + vertice.y*axis.y);
-        for(auto&& vertice : second)
-            projection2.addPoint(vertice.x*axis.x + vertice.y*axis.y);
-
-        auto currentOverlap = overlap(projection, projection2);
-
-        //by SAT we know that if projections don't overlap on at least one axis, then they don't collide
-        if(!currentOverlap) {
-            return {0.f, 0.f};
-        }
+    broadPhase.forEachPair([this](EntityID first, EntityID second) { resolveCollision(first, second); });
 
-        if(currentOverlap < minOverlap) {
-            minOverlap = currentOverlap;
-            minOverlapAxis = axis;
-            minOverlapSecondProjection = projection2;
-        }
+    //bodies pushed apart were changed by this update, so the next one won't see them as changed
+    for (auto entity : pushedBodies) {
+        updateBody(entity, *ecs.components.getComponent<const CollisionComponent>(entity),
+                   *ecs.components.getComponent<const PositionComponent>(entity),
+                   *ecs.components.getComponent<const SizeComponent>(entity));
     }
-
-    auto MTV = sf::Vector2f(minOverlapAxis.x * minOverlap, minOverlapAxis.y * minOverlap);
-
-    //Ensure MTV have good sign by testing if applied on first body it really separates them
-    auto testProjection = Projection{};
-    for(auto&& vertice : first)
-        testProjection.addPoint((vertice.x + MTV.x)*minOverlapAxis.x + (vertice.y + MTV.y)*minOverlapAxis.y);
-    
-    auto newOverlap = overlap(testProjection, minOverlapSecondProjection);
-    if(newOverlap != 0.f)
-        MTV = -MTV;
-
-    return MTV;
+    pushedBodies.clear();
 }
 
-float CollisionDetector::overlap(Projection first, Projection second) {
-    return std::max(0.f, std::min(first.max, second.max) - std::max(first.min, second.min));
+void CollisionDetector::updateBody(EntityID entity, const CollisionComponent& collision,
+                                   const PositionComponent& position, const SizeComponent& size) {
+    auto box = SpatialHash::Box{position.position.x, position.position.y, position.position.x + size.width,
+                                position.position.y + size.height};
+    broadPhase.update(entity, box, collision.isStatic);
 }
 
-std::array<sf::Vector2f, 4> CollisionDetector::getVertices(const PositionComponent& pos, const SizeComponent& size) {
-    auto transform = sf::Transform{};
-    transform.translate(pos.position);
-    return {transform.transformPoint({0, 0}),
-            transform.transformPoint({size.width, 0}),
-            transform.transformPoint({size.width, size.height}),
-            transform.transformPoint({0, size.height})};
-}
-
-void CollisionDetector::appendAxes(std::vector<sf::Vector2f>& where, const std::array<sf::Vector2f, 4>& srcVertices) {
-    sf::Vector2f firstSide = srcVertices[0] - srcVertices[1];
-    sf::Vector2f secondSide = srcVertices[0] - srcVertices[3];
+//narrow phase: checks if bodies really collide, and if so separates them and emits event
+void CollisionDetector::resolveCollision(EntityID aEntity, EntityID bEntity) {
+    auto aCollision = ecs.components.getComponent<const CollisionComponent>(aEntity);
+    auto bCollision = ecs.components.getComponent<const CollisionComponent>(bEntity);
+    auto aPosition = ecs.components.getComponent<const PositionComponent>(aEntity);
+    auto bPosition = ecs.components.getComponent<const PositionComponent>(bEntity);
+    auto aSize = ecs.components.getComponent<const SizeComponent>(aEntity);
+    auto bSize = ecs.components.getComponent<const SizeComponent>(bEntity);
+
+    bool emitEvent = aCollision->emitEvent || bCollision->emitEvent;
+    bool pushAnything = aCollision->pushFromCollision || bCollision->pushFromCollision;
+    if (!(emitEvent || pushAnything))
+        return;
+
+    auto MTV = calculateCollision(*aPosition, *aSize, *bPosition, *bSize);
+
+    auto bodiesCollide = MTV.x != 0.f || MTV.y != 0.f;
+    if(bodiesCollide) {
+        auto firstBodyTranslation = sf::Vector2f{};
+        auto secondBodyTranslation = sf::Vector2f{};
+
+        if(aCollision->pushFromCollision) {
+            //if both are to be pushed, push each by 1/2 of MTV in opposite directions.
+            if(bCollision->pushFromCollision) {
+                firstBodyTranslation = {MTV.x / 2.f, MTV.y / 2.f};
+                secondBodyTranslation = {-MTV.x / 2.f, -MTV.y / 2.f};
+            } else
+                firstBodyTranslation = MTV;
+        } else if(bCollision->pushFromCollision)
+            secondBodyTranslation = -MTV;
+
+        //only bodies which are really pushed are marked as changed, so walls stay where they were bucketed
+        if(aCollision->pushFromCollision) {
+            ecs.components.getComponent<PositionComponent>(aEntity)->position += firstBodyTranslation;
+            pushedBodies.push_back(aEntity);
+        }
+        if(bCollision->pushFromCollision) {
+            ecs.components.getComponent<PositionComponent>(bEntity)->position += secondBodyTranslation;
+            pushedBodies.push_back(bEntity);
+        }
 
-    //normalize axes
-	auto len = float{sqrt(firstSide.x*firstSide.x + firstSide.y*firstSide.y)};
-    firstSide = {firstSide.x / len, firstSide.y / len};
+        if(aCollision->emitEvent || bCollision->emitEvent) {
+            CollisionEvent event;
+            
+            event.firstBody = aEntity;
+            event.secondBody = bEntity;
+            event.firstBodyTranslation = firstBodyTranslation;
+            event.secondBodyTranslation = secondBodyTranslation;
+            event.minimumTranslationVector = MTV;
+            ecs.events.push(std::move(event));
+        }
+    }
+}
 
-	len = float{sqrt(secondSide.x*secondSide.x + secondSide.y*secondSide.y)};
-    secondSide = {secondSide.x / len, secondSide.y / len};
+//returns MTV that you can apply to first. MTV == 0.f if they don't collide
+//all bodies are axis-aligned rectangles, so it's enough to push first one along the axis of smaller overlap
+sf::Vector2f CollisionDetector::calculateCollision(const PositionComponent& firstPosition, const SizeComponent& firstSize,
+                                                   const PositionComponent& secondPosition, const SizeComponent& secondSize) {
+    auto first = sf::FloatRect(firstPosition.position, {firstSize.width, firstSize.height});
+    auto second = sf::FloatRect(secondPosition.position, {secondSize.width, secondSize.height});
+
+    auto overlapX = std::min(first.left + first.width, second.left + second.width) - std::max(first.left, second.left);
+    auto overlapY = std::min(first.top + first.height, second.top + second.height) - std::max(first.top, second.top);
+    if(overlapX <= 0.f || overlapY <= 0.f)
+        return {0.f, 0.f};
+
+    //push first body away from center of the second one
+    if(overlapX < overlapY) {
+        auto firstIsLeft = first.left + first.width / 2.f < second.left + second.width / 2.f;
+        return {firstIsLeft ? -overlapX : overlapX, 0.f};
+    }
 
-    where.push_back({-firstSide.y, firstSide.x});
-    where.push_back({-secondSide.y, secondSide.x});
+    auto firstIsAbove = first.top + first.height / 2.f < second.top + second.height / 2.f;
+    return {0.f, firstIsAbove ? -overlapY : overlapY};
 }
-
@@ -1,27 +1,36 @@
 #pragma once
 #include <ecs/ecs.h>
-#include <array>
 #include <SFML/Graphics.hpp>
 
 using namespace EECS;
 
-class Projection;
+struct CollisionComponent;
 struct PositionComponent;
 struct SizeComponent;
-class CollisionDetector : public Task<CollisionDetector> {
+struct CollisionEvent;
+class CollisionDetector : public Task<CollisionDetector, Reads<CollisionComponent, SizeComponent>,
+                                                         Writes<PositionComponent, CollisionEvent>> {
 public:
 	CollisionDetector(ECS& engine, sf::RenderWindow& window) :
 			Task(engine),
-			window(window) {
+			window(window),
+			broadPhase(engine.config.get("tasks.collisionDetector.cellSize", 1.f)) {
 	}
 	void update() override;
 
 private:
-    sf::Vector2f calculateCollision(const std::array<sf::Vector2f, 4>& first, const std::array<sf::Vector2f, 4>& secnd);
-    float overlap(Projection first, Projection second);
-    std::array<sf::Vector2f, 4> getVertices(const PositionComponent& position, const SizeComponent& size);
-    void appendAxes(std::vector<sf::Vector2f>& where, const std::array<sf::Vector2f, 4>& sourceVertices);
+    sf::Vector2f calculateCollision(const PositionComponent& firstPosition, const SizeComponent& firstSize,
+                                    const PositionComponent& secondPosition, const SizeComponent& secondSize);
+    void resolveCollision(EntityID first, EntityID second);
+    void updateBody(EntityID entity, const CollisionComponent& collision, const PositionComponent& position,
+                    const SizeComponent& size);
 
 	sf::RenderWindow& window;
+
+    // bodies which take part in collision detection. Kept between updates, so static ones are bucketed once.
+    SpatialHash broadPhase;
+
+    // bodies moved by resolveCollision during current update
+    std::vector<EntityID> pushedBodies;
 };
 
@@ -1,10 +1,13 @@
 #include "controller.h"
+#include <string>
+#include <vector>
 #include "../states/play_state.h"
 #include "../tasks/sfml_input_proxy.h"
 #include "../tasks/echo_events.h"
 #include "../tasks/renderer.h"
 #include "../tasks/movement_task.h"
 #include "../tasks/collision_detector.h"
+#include "../tasks/render_benchmark.h"
 
 using namespace EECS;
 
@@ -16,8 +19,21 @@ Controller::Controller(ECS& ecs) : Task(ecs) {
 	ecs.tasks.addTask<CollisionDetector>(window);
     ecs.tasks.addTask<Renderer>(window);
 
+    //benchmark renders its own scene instead of the game
+    if (ecs.config.get("tasks.renderBenchmark.enabled", std::string("false")) == "true") {
+        ecs.tasks.addTask<RenderBenchmark>();
+        return;
+    }
+
+    //pacmen are small, so they're packed together and drawn in a single batch
+    auto atlasSize = ecs.config.get("textures.atlasSize", 1024u);
+    auto atlasImages = std::vector<std::string>{ ecs.config.get("gameplay.pacman.texture"),
+                                                 ecs.config.get("gameplay.secondPacman.texture") };
+    if (atlasSize > 0 && !textures.buildAtlas(atlasImages, atlasSize))
+        ecs.logger.warn("Controller: sprites don't fit in texture atlas, separate textures will be used");
+
 	//start the gameplay immediately
-	states.push(std::make_unique<PlayState>(ecs, window));
+	states.push(std::make_unique<PlayState>(ecs, window, textures));
 }
 
 void Controller::update() {
@@ -2,6 +2,7 @@
 #include <ecs/ecs.h>
 #include <SFML/Graphics.hpp>
 #include "../states/pushdown_automata.h"
+#include "../resources/texture_cache.h"
 
 using namespace EECS;
 
@@ -11,6 +12,7 @@ public:
 	void update() override;
 
 private:
+    TextureCache textures;
     PushdownAutomata states;
     sf::RenderWindow window;
 };
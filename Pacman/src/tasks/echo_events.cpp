@@ -1,7 +1,7 @@
 #include "echo_events.h"
 #include "../events/system_events.h"
 
-EchoEvents::EchoEvents(ECS& ecs) : Task<EchoEvents>(ecs), Receives(ecs.events), logger("EchoEvents") {
+EchoEvents::EchoEvents(ECS& ecs) : Task(ecs), Receives(ecs.events), logger("EchoEvents") {
 	if(ecs.config.get("tasks.echo_events.log") == "true") {
 		auto cOut = std::make_shared<ConsoleOutput>();
 		cOut->setMinPriority(LogType::Information);
@@ -12,7 +12,7 @@ struct MouseButtonPressed;
 struct MouseButtonReleased;
 struct MouseMoved;
 struct MouseWheelMoved;
-class EchoEvents : public Task<EchoEvents>, Receives<EchoEvents, UnknownSFMLEvent, ApplicationClosed, KeyPressed, KeyReleased, TextEntered, MouseButtonPressed, MouseButtonReleased, MouseMoved, MouseWheelMoved> {
+class EchoEvents : public Task<EchoEvents, Reads<>>, Receives<EchoEvents, UnknownSFMLEvent, ApplicationClosed, KeyPressed, KeyReleased, TextEntered, MouseButtonPressed, MouseButtonReleased, MouseMoved, MouseWheelMoved> {
 public:
 	EchoEvents(ECS& ecs);
 
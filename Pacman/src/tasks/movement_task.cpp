@@ -4,15 +4,12 @@
 
 using namespace EECS;
 
-MovementTask::MovementTask(ECS& engine) : Task<MovementTask>(engine) { }
+MovementTask::MovementTask(ECS& engine) : Task(engine) { }
 
 void MovementTask::update() {
-    auto elapsedTime = (float)frequency.count() / 1000;
+    auto elapsedTime = std::chrono::duration<float>(frequency).count();
 
-	auto physical = ecs.components.intersection<MovementComponent, PositionComponent>();
-	for (auto&& obj : physical) {
-        auto& pos = obj.get<PositionComponent>();
-        auto& movement = obj.get<MovementComponent>();
+	for (auto [entity, movement, pos] : ecs.components.view<const MovementComponent, PositionComponent>()) {
         float displacement = movement.speed * elapsedTime;
 
         switch (movement.direction) {
@@ -3,7 +3,9 @@
 
 using namespace EECS;
 
-class MovementTask : public Task<MovementTask> {
+struct MovementComponent;
+struct PositionComponent;
+class MovementTask : public Task<MovementTask, Reads<MovementComponent>, Writes<PositionComponent>> {
 public:
     MovementTask(ECS& engine);
     void update() override;
@@ -0,0 +1,93 @@
+#include "render_benchmark.h"
+#include <algorithm>
+#include <random>
+#include "renderer.h"
+#include "../components/position_component.h"
+#include "../components/size_component.h"
+#include "../components/graphics_component.h"
+
+using namespace EECS;
+
+RenderBenchmark::RenderBenchmark(ECS& engine) : Task(engine) {
+    spriteCount = engine.config.get("tasks.renderBenchmark.sprites", 10000u);
+    frameCount = engine.config.get("tasks.renderBenchmark.frames", 600u);
+    planeCount = std::max(1u, engine.config.get("tasks.renderBenchmark.planes", 8u));
+
+    auto textureCount = std::max(1u, engine.config.get("tasks.renderBenchmark.textures", 4u));
+    for (auto i = 0u; i < textureCount; i++) {
+        textures.push_back(std::make_shared<sf::Texture>());
+        textures.back()->create(16, 16);
+    }
+
+    area.width = engine.config.get("tasks.renderer.initialView.width", 16.0f);
+    area.height = engine.config.get("tasks.renderer.initialView.height", 9.0f);
+
+    renderer = ecs.tasks.getTask<Renderer>();
+    if (!renderer)
+        ecs.logger.error("RenderBenchmark: renderer isn't running, nothing will be measured");
+
+    spawnSprites();
+}
+
+void RenderBenchmark::update() {
+    //stats are of the frame rendered after previous update
+    if (renderer && framesDone > 0) {
+        const auto& stats = renderer->lastFrameStats();
+        drawCalls += stats.drawCalls;
+        vertices += stats.vertices;
+        cpuTime += stats.cpuTime;
+        maxCpuTime = std::max(maxCpuTime, stats.cpuTime);
+    }
+
+    if (framesDone++ == frameCount) {
+        report();
+        ecs.stop();
+        return;
+    }
+
+    moveSprites();
+}
+
+void RenderBenchmark::spawnSprites() {
+    //fixed seed, so that every run renders the same scene
+    auto random = std::mt19937{1337};
+    auto uniform = [&](float min, float max) { return std::uniform_real_distribution<float>(min, max)(random); };
+
+    for (auto i = 0u; i < spriteCount; i++) {
+        auto sprite = ecs.entities.addEntity();
+        auto size = sprite.addComponent<SizeComponent>(uniform(0.1f, 1.f), uniform(0.1f, 1.f));
+        sprite.addComponent<PositionComponent>(uniform(0, area.width - size->width),
+                                               uniform(0, area.height - size->height));
+
+        auto graphics = sprite.addComponent<GraphicsComponent>((int)(random() % planeCount));
+        graphics->texture = textures[random() % textures.size()];
+
+        sprites.push_back(sprite);
+        velocities.push_back({uniform(-0.1f, 0.1f), uniform(-0.1f, 0.1f)});
+    }
+}
+
+void RenderBenchmark::moveSprites() {
+    //moved by constant distance per frame rather than per time, to keep frames the same regardless of timing
+    for (auto i = 0u; i < sprites.size(); i++) {
+        auto& position = ecs.components.getComponent<PositionComponent>(sprites[i])->position;
+        auto size = ecs.components.getComponent<const SizeComponent>(sprites[i]);
+
+        position += velocities[i];
+        if (position.x < area.left || position.x + size->width > area.left + area.width)
+            velocities[i].x = -velocities[i].x;
+        if (position.y < area.top || position.y + size->height > area.top + area.height)
+            velocities[i].y = -velocities[i].y;
+    }
+}
+
+void RenderBenchmark::report() {
+    auto frames = std::max(1u, frameCount);
+    auto msPerFrame = std::chrono::duration<double, std::milli>(cpuTime).count() / frames;
+    auto maxMs = std::chrono::duration<double, std::milli>(maxCpuTime).count();
+
+    ecs.logger.info("RenderBenchmark: ", spriteCount, " sprites, ", frameCount, " frames",
+                    renderer && renderer->isHeadless() ? " (headless)" : "", ": ",
+                    drawCalls / frames, " draw calls/frame, ", vertices / frames, " vertices/frame, ",
+                    msPerFrame, " CPU ms/frame(max ", maxMs, ")");
+}
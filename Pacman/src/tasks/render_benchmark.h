@@ -0,0 +1,48 @@
+#pragma once
+#include <ecs/ecs.h>
+#include <SFML/Graphics.hpp>
+#include <chrono>
+#include <memory>
+#include <vector>
+
+using namespace EECS;
+
+struct PositionComponent;
+struct SizeComponent;
+struct GraphicsComponent;
+class Renderer;
+
+//renders the same scene of many moving sprites for given amount of frames, then logs cost of rendering it and stops
+//the engine. Scene depends only on configuration(tasks.renderBenchmark), so results of runs can be compared.
+class RenderBenchmark : public Task<RenderBenchmark, MainThread,
+                                    Writes<PositionComponent, SizeComponent, GraphicsComponent>> {
+public:
+    explicit RenderBenchmark(ECS& engine);
+    void update() override;
+
+private:
+    void spawnSprites();
+    void moveSprites();
+    void report();
+
+    Renderer* renderer = nullptr;
+
+    unsigned spriteCount;
+    unsigned frameCount;
+    unsigned framesDone = 0;
+
+    //sprites are spread between that many planes and textures
+    unsigned planeCount;
+    std::vector<std::shared_ptr<sf::Texture>> textures;
+
+    //sprites bounce inside of this area
+    sf::FloatRect area;
+    std::vector<EntityID> sprites;
+    std::vector<sf::Vector2f> velocities;
+
+    //sums of stats of all measured frames
+    size_t drawCalls = 0;
+    size_t vertices = 0;
+    std::chrono::nanoseconds cpuTime{0};
+    std::chrono::nanoseconds maxCpuTime{0};
+};
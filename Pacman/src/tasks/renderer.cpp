@@ -1,4 +1,7 @@
 #include "renderer.h"
+#include <algorithm>
+#include <functional>
+#include <type_traits>
 #include "../components/position_component.h"
 #include "../components/size_component.h"
 #include "../components/movement_component.h"
@@ -6,101 +9,276 @@
 #include "../components/gui_text_component.h"
 
 void Renderer::update() {
-    window.clear(fillColor);
+    auto timer = Timer{};
+    frameStats = {};
+
+    if (target) {
+        //in headless mode view is still changed on the window by other tasks, it's just never opened
+        if (headless)
+            target->setView(window.getView());
+        target->clear(fillColor);
+    }
+
     renderSprites();
     renderText();
-    window.display();
+
+    if (target == &offscreen)
+        offscreen.display();
+    else if (target)
+        window.display();
+
+    frameStats.cpuTime = timer.elapsed();
 }
 
 void Renderer::renderSprites() {
-    auto ents = ecs.components.intersection<GraphicsComponent, SizeComponent, PositionComponent>();
-
-    //calculate planes range
-    auto maxPlane = std::numeric_limits<int>::min();
-    auto minPlane = std::numeric_limits<int>::max();
-    for (auto&& gfx : ents) {
-        maxPlane = (maxPlane < gfx.get<GraphicsComponent>().plane ? gfx.get<GraphicsComponent>().plane : maxPlane);
-        minPlane = (minPlane > gfx.get<GraphicsComponent>().plane ? gfx.get<GraphicsComponent>().plane : minPlane);
+    if (spritesDirty)
+        rebuildSprites();
+    else
+        updateChangedSprites();
+
+    drawSprites();
+}
+
+void Renderer::drawSprites() {
+    if (culling && cullSprites())
+        drawBatches(culledBatches);
+    else
+        drawBatches(batches);
+}
+
+bool Renderer::cullSprites() {
+    //in headless mode view is copied from the window too, so it's the one which is drawn. Inverse transform maps
+    //corners of the target back to the world, and their bounding box covers rotated views too
+    auto area = window.getView().getInverseTransform().transformRect({-1.f, -1.f, 2.f, 2.f});
+    auto box = SpatialHash::Box{area.left, area.top, area.left + area.width, area.top + area.height};
+
+    visible.clear();
+    spriteIndex.forEachInBox(box, [&](EntityID entity) { visible.push_back(spriteOf.get(entity)); });
+    if (visible.size() == sprites.size())
+        return false;
+
+    //only visible sprites are put back in drawing order, by their positions in the retained order
+    radixSort(visible, visibleScratch, [](uint32_t sprite) { return sprite; });
+
+    //visible sprites which are next to each other in the retained order are drawn as one range of retained vertices
+    culledBatches.clear();
+    for (auto sprite : visible) {
+        auto continuesLast = !culledBatches.empty() && culledBatches.back().texture == sprites[sprite].texture &&
+                             culledBatches.back().firstVertex + culledBatches.back().vertexCount == sprite * 4;
+        if (!continuesLast)
+            culledBatches.push_back({sprites[sprite].texture, sprite * 4, 0});
+        culledBatches.back().vertexCount += 4;
+    }
+    return true;
+}
+
+void Renderer::drawBatches(const std::vector<Batch>& toDraw) {
+    for (const auto& batch : toDraw) {
+        frameStats.drawCalls++;
+        frameStats.vertices += batch.vertexCount;
+        if (!target)
+            continue;
+
+        auto state = sf::RenderStates{batch.texture};
+        if (useVertexBuffer)
+            target->draw(vertexBuffer, batch.firstVertex, batch.vertexCount, state);
+        else
+            target->draw(vertices.data() + batch.firstVertex, batch.vertexCount, sf::Quads, state);
+    }
+}
+
+void Renderer::rebuildSprites() {
+    for (const auto& sprite : sprites)
+        spriteOf.reset(sprite.entity);
+    sprites.clear();
+    spriteIndex.clear();
+
+    //ranks are given only to textures in use, so freed ones don't pile up, and new texture at the address of freed one
+    //doesn't inherit its rank
+    textureRanks.clear();
+
+    auto& ents = ecs.components.group<const GraphicsComponent, const SizeComponent, const PositionComponent>();
+    for (auto [entity, graphics, size, position] : ents)
+        sprites.push_back({entity, graphics.plane, graphics.texture.get(), orderOf(graphics.plane, graphics.texture.get())});
+
+    //single pass over sprites per byte of the order, instead of a pass per plane
+    radixSort(sprites, sortScratch, [](const Sprite& sprite) { return sprite.order; });
+
+    vertices.resize(sprites.size() * 4);
+    batches.clear();
+    for (auto i = 0u; i < sprites.size(); i++) {
+        spriteOf.set(sprites[i].entity, i);
+        writeQuad(i, *ecs.components.getComponent<const GraphicsComponent>(sprites[i].entity),
+                  *ecs.components.getComponent<const SizeComponent>(sprites[i].entity),
+                  *ecs.components.getComponent<const PositionComponent>(sprites[i].entity));
+
+        if (batches.empty() || batches.back().texture != sprites[i].texture)
+            batches.push_back({sprites[i].texture, i * 4, 0});
+        batches.back().vertexCount += 4;
+    }
+
+    if (useVertexBuffer) {
+        vertexBuffer.create(vertices.size());
+        vertexBuffer.update(vertices.data());
     }
+    spritesDirty = false;
+}
+
+uint64_t Renderer::orderOf(int plane, const sf::Texture* texture) {
+    auto rank = textureRanks.try_emplace(texture, (uint32_t)textureRanks.size()).first->second;
+
+    //planes are drawn from high to low, so biased plane is inverted
+    auto planeOrder = ~((uint32_t)plane ^ 0x80000000u);
+    return (uint64_t)planeOrder << 32 | rank;
+}
+
+void Renderer::updateChangedSprites() {
+    updateSpritesWithChanged<GraphicsComponent>();
+    updateSpritesWithChanged<SizeComponent>();
+    updateSpritesWithChanged<PositionComponent>();
+    updateSpritesWithChanged<MovementComponent>();
+
+    //plane or texture changed, so order has to be rebuilt
+    if (spritesDirty)
+        rebuildSprites();
+}
+
+template <typename ComponentType>
+void Renderer::updateSpritesWithChanged() {
+    for (auto [entity, changed] : ecs.components.view<Changed<const ComponentType>>(lastUpdateTick)) {
+        auto sprite = spriteOf.get(entity);
+        if (spritesDirty || sprite == SparseIndex::npos || sprites[sprite].entity != entity)
+            continue;
 
-    for (auto currentPlane = maxPlane; currentPlane >= minPlane; currentPlane--) {
-        for (auto&& gfx : ents) {
-            if (gfx.get<GraphicsComponent>().plane != currentPlane)
-                continue; 
-            auto state = sf::RenderStates{};
-
-            if (auto movementComp = ecs.components.getComponent<MovementComponent>(gfx.entity())) {
-                float rotation = 0;
-                if (movementComp->direction == Direction::UP)
-                    rotation = -90;
-                else if (movementComp->direction == Direction::DOWN)
-                    rotation = 90;
-                else if (movementComp->direction == Direction::LEFT)
-                    rotation = 180;
-
-                state.transform.rotate(rotation,
-                    gfx.get<PositionComponent>().position.x + gfx.get<SizeComponent>().width / 2,
-                    gfx.get<PositionComponent>().position.y + gfx.get<SizeComponent>().height / 2);
-            }
-            state.transform.translate(gfx.get<PositionComponent>().position);
-
-            //prepare sprite vertices
-            sf::Vertex vertices[4];
-
-            //positions are in local(object) coordinate space, it's translated to world space later
-            vertices[0].position = { 0, 0 };
-            vertices[1].position = { gfx.get<SizeComponent>().width, 0 };
-            vertices[2].position = { gfx.get<SizeComponent>().width, gfx.get<SizeComponent>().height };
-            vertices[3].position = { 0, gfx.get<SizeComponent>().height };
-
-            for (auto&& v : vertices)
-                v.color = gfx.get<GraphicsComponent>().color;
-
-            if (gfx.get<GraphicsComponent>().texture) {
-                state.texture = gfx.get<GraphicsComponent>().texture.get();
-                vertices[0].texCoords = { 0, 0 };
-                vertices[1].texCoords = { (float)gfx.get<GraphicsComponent>().texture->getSize().x, 0 };
-                vertices[2].texCoords = { (float)gfx.get<GraphicsComponent>().texture->getSize().x,
-                                          (float)gfx.get<GraphicsComponent>().texture->getSize().y };
-                vertices[3].texCoords = { 0, (float)gfx.get<GraphicsComponent>().texture->getSize().y };
-            }
-
-            window.draw(vertices, 4, sf::Quads, state);
+        auto graphics = ecs.components.getComponent<const GraphicsComponent>(entity);
+        if (graphics->plane != sprites[sprite].plane || graphics->texture.get() != sprites[sprite].texture) {
+            spritesDirty = true;
+            continue;
         }
+
+        writeQuad(sprite, *graphics, *ecs.components.getComponent<const SizeComponent>(entity),
+                  *ecs.components.getComponent<const PositionComponent>(entity));
+        if (useVertexBuffer)
+            vertexBuffer.update(vertices.data() + sprite * 4, 4, sprite * 4);
+    }
+}
+
+void Renderer::writeQuad(size_t sprite, const GraphicsComponent& graphics, const SizeComponent& size,
+                         const PositionComponent& position) {
+    auto transform = sf::Transform{};
+    if (auto movementComp = ecs.components.getComponent<const MovementComponent>(sprites[sprite].entity)) {
+        float rotation = 0;
+        if (movementComp->direction == Direction::UP)
+            rotation = -90;
+        else if (movementComp->direction == Direction::DOWN)
+            rotation = 90;
+        else if (movementComp->direction == Direction::LEFT)
+            rotation = 180;
+
+        transform.rotate(rotation,
+            position.position.x + size.width / 2,
+            position.position.y + size.height / 2);
+    }
+    transform.translate(position.position);
+
+    //positions are in local(object) coordinate space, they're translated to world space here, so that whole batch
+    //can be drawn without changing transform
+    auto quad = &vertices[sprite * 4];
+    quad[0].position = transform.transformPoint(0, 0);
+    quad[1].position = transform.transformPoint(size.width, 0);
+    quad[2].position = transform.transformPoint(size.width, size.height);
+    quad[3].position = transform.transformPoint(0, size.height);
+
+    auto bounds = SpatialHash::Box{quad[0].position.x, quad[0].position.y, quad[0].position.x, quad[0].position.y};
+    for (auto i = 1; i < 4; i++) {
+        bounds.left = std::min(bounds.left, quad[i].position.x);
+        bounds.top = std::min(bounds.top, quad[i].position.y);
+        bounds.right = std::max(bounds.right, quad[i].position.x);
+        bounds.bottom = std::max(bounds.bottom, quad[i].position.y);
+    }
+    spriteIndex.update(sprites[sprite].entity, bounds, true);
+
+    for (auto i = 0; i < 4; i++)
+        quad[i].color = graphics.color;
+
+    if (graphics.texture) {
+        auto rect = sf::FloatRect(graphics.textureRect);
+        if (rect.width == 0 || rect.height == 0)
+            rect = { {0, 0}, sf::Vector2f(graphics.texture->getSize()) };
+
+        quad[0].texCoords = { rect.left, rect.top };
+        quad[1].texCoords = { rect.left + rect.width, rect.top };
+        quad[2].texCoords = { rect.left + rect.width, rect.top + rect.height };
+        quad[3].texCoords = { rect.left, rect.top + rect.height };
     }
 }
 
 void Renderer::renderText() {
-    auto currView = window.getView();
-    window.setView(window.getDefaultView());
+    if (!target)
+        return;
 
-    auto texts = ecs.components.intersection<GUITextComponent, PositionComponent>();
+    auto currView = target->getView();
+    target->setView(target->getDefaultView());
 
-    for (auto i = 0u; i < texts.size(); i++) {
-        texts[i].get<GUITextComponent>().text.setPosition(texts[i].get<PositionComponent>().position);
-        window.draw(texts[i].get<GUITextComponent>().text);
+    for (auto [entity, text, position] : ecs.components.view<GUITextComponent, const PositionComponent>()) {
+        text.text.setPosition(position.position);
+        target->draw(text.text);
+        frameStats.drawCalls++;
     }
 
-    window.setView(currView);
+    target->setView(currView);
 }
 
 Renderer::Renderer(ECS& engine, sf::RenderWindow& window) : Task(engine), window(window) {
+    //sprites have to be ordered again when any of them is added or removed
+    auto observeSprites = [this](auto* component) {
+        using ComponentType = std::remove_pointer_t<decltype(component)>;
+        for (auto change : { ComponentChange::Added, ComponentChange::Removed }) {
+            auto id = ecs.components.observe<ComponentType>(change, [this](EntityID, ComponentType&) { spritesDirty = true; });
+            stopObserving.push_back([this, id] { ecs.components.unobserve<ComponentType>(id); });
+        }
+    };
+    observeSprites((GraphicsComponent*)nullptr);
+    observeSprites((SizeComponent*)nullptr);
+    observeSprites((PositionComponent*)nullptr);
+
     auto resX = engine.config.get("tasks.renderer.resolution.x", 1600u);
     auto resY = engine.config.get("tasks.renderer.resolution.y", 900u);
     auto winTitle = engine.config.get("tasks.renderer.windowTitle");
     auto fullscreen = engine.config.get("tasks.renderer.fullscreen", std::string("false")) == "true";
-    if (fullscreen)
-        window.create(sf::VideoMode::getFullscreenModes()[0], winTitle, sf::Style::Fullscreen);
-    else
-        window.create(sf::VideoMode(resX, resY, 32), winTitle);
+    headless = engine.config.get("tasks.renderer.headless", std::string("false")) == "true";
+    if (headless) {
+        if (offscreen.create(resX, resY))
+            target = &offscreen;
+        else
+            engine.logger.warn("Renderer: failed to create offscreen target, frames will be prepared but not drawn");
+    }
+    else {
+        if (fullscreen)
+            window.create(sf::VideoMode::getFullscreenModes()[0], winTitle, sf::Style::Fullscreen);
+        else
+            window.create(sf::VideoMode(resX, resY, 32), winTitle);
+        target = &window;
+    }
 
     fillColor.r = engine.config.get("tasks.renderer.fillColor.red", 0u);
     fillColor.g = engine.config.get("tasks.renderer.fillColor.green", 0u);
     fillColor.b = engine.config.get("tasks.renderer.fillColor.blue", 0u);
 
+    culling = engine.config.get("tasks.renderer.culling.enabled", std::string("true")) == "true";
+    spriteIndex.setCellSize(engine.config.get("tasks.renderer.culling.cellSize", 4.0f));
+
     auto left = engine.config.get("tasks.renderer.initialView.left", 0.0f);
     auto top = engine.config.get("tasks.renderer.initialView.top", 0.0f);
     auto width = engine.config.get("tasks.renderer.initialView.width", (float)resX);
     auto height = engine.config.get("tasks.renderer.initialView.height", (float)resY);
     window.setView(sf::View({ left, top, width, height }));
+
+    //needs context of the target, falls back to drawing vertices from memory
+    useVertexBuffer = target && sf::VertexBuffer::isAvailable();
+}
+
+Renderer::~Renderer() {
+    for (auto& stop : stopObserving)
+        stop();
 }
@@ -1,21 +1,123 @@
 #pragma once
 #include <ecs/ecs.h>
 #include <SFML/Graphics.hpp>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <unordered_map>
+#include <vector>
 
 using namespace EECS;
 
-class Renderer : public Task<Renderer> {
+struct PositionComponent;
+struct SizeComponent;
+struct MovementComponent;
+struct GraphicsComponent;
+struct GUITextComponent;
+class Renderer : public Task<Renderer, MainThread,
+                             Reads<PositionComponent, SizeComponent, MovementComponent, GraphicsComponent>,
+                             Writes<GUITextComponent>> {
 public:
 	Renderer(ECS& engine, sf::RenderWindow& window);
+    ~Renderer();
 	void update() override;
 
+    //work done to render a single frame
+    struct FrameStats {
+        size_t drawCalls = 0;
+        size_t vertices = 0; //submitted by draw calls, not uploaded
+        std::chrono::nanoseconds cpuTime{0};
+    };
+
+    //stats of the last rendered frame
+    const FrameStats& lastFrameStats() const { return frameStats; }
+
+    //true if frames are rendered offscreen instead of into the window, see tasks.renderer.headless
+    bool isHeadless() const { return headless; }
+
 private:
+    //sprite in drawing order, with keys it's ordered by
+    struct Sprite {
+        EntityID entity;
+        int plane;
+        const sf::Texture* texture;
+
+        //higher plane first, then grouped by texture
+        uint64_t order;
+    };
+
+    //consecutive sprites with the same texture, drawn with single call
+    struct Batch {
+        const sf::Texture* texture;
+        size_t firstVertex;
+        size_t vertexCount;
+    };
+
     void renderSprites();
     void renderText();
 
-    //mainly for rendering into it
+    //orders all sprites, builds their vertices and batches, and uploads them
+    void rebuildSprites();
+    uint64_t orderOf(int plane, const sf::Texture* texture);
+
+    //rebuilds vertices of sprites which changed since last update, uploads only them
+    void updateChangedSprites();
+    template <typename ComponentType>
+    void updateSpritesWithChanged();
+
+    //transforms sprite's quad on CPU, so that whole batch can be drawn at once
+    void writeQuad(size_t sprite, const GraphicsComponent& graphics, const SizeComponent& size,
+                   const PositionComponent& position);
+
+    //draws sprites inside of the view, or all of them if culling is disabled
+    void drawSprites();
+
+    //finds sprites inside of the view and groups them into culled batches - ranges of retained vertices. Returns false
+    //if all sprites are visible, so retained batches can be drawn instead
+    bool cullSprites();
+
+    //draws given batches from the vertex buffer, or from memory if it's not available, and counts them in stats
+    void drawBatches(const std::vector<Batch>& toDraw);
+
+    //mainly for rendering into it. In headless mode it's never opened, only its view is used
 	sf::RenderWindow& window;
 
+    //window, or offscreen texture in headless mode. Null if offscreen texture couldn't be created - then frames are
+    //only prepared, without drawing anything
+    sf::RenderTarget* target = nullptr;
+    sf::RenderTexture offscreen;
+    bool headless = false;
+
+    FrameStats frameStats;
+
     //color of background
 	sf::Color fillColor;
+
+    //kept between frames, rebuilt only when sprites are added, removed, or change their plane or texture
+    std::vector<Sprite> sprites;
+    std::vector<Batch> batches;
+    std::vector<sf::Vertex> vertices; //4 per sprite, in order of sprites
+    SparseIndex spriteOf;
+    std::vector<Sprite> sortScratch;
+    bool spritesDirty = true;
+
+    //textures numbered in order of appearance in the last rebuild, so that they fit in low bits of sprite's order
+    std::unordered_map<const sf::Texture*, uint32_t> textureRanks;
+
+    //bounding boxes of sprites in world space, updated with their quads. All bodies are static - their boxes are kept
+    //in cells, so that querying them is fast
+    SpatialHash spriteIndex;
+    bool culling = true;
+
+    //visible sprites of the current frame, in drawing order
+    std::vector<uint32_t> visible;
+    std::vector<uint32_t> visibleScratch;
+    std::vector<Batch> culledBatches;
+
+    //copy of vertices in GPU memory, if available
+    sf::VertexBuffer vertexBuffer{sf::Quads, sf::VertexBuffer::Dynamic};
+    bool useVertexBuffer = false;
+
+    //observers which mark sprites dirty, unregistered in destructor
+    std::vector<std::function<void()>> stopObserving;
 };